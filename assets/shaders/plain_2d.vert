@@ -2,18 +2,19 @@
 
 layout(location = 0) in vec2 in_position_m;
 
+// The model matrix of the instance, as the columns of a 2D affine transform.
+layout(location = 1) in vec2 in_axis_x;
+layout(location = 2) in vec2 in_axis_y;
+layout(location = 3) in vec2 in_translation;
+
 layout(binding = 1, std140) uniform PerFrame
 {
 	mat3 view_matrix;
 	mat3 projection_matrix;
 };
 
-layout(binding = 2, std140) uniform PerInstance
-{
-	mat3 model_matrix;
-};
-
 void main()
 {
+	mat3 model_matrix = mat3(vec3(in_axis_x, 0.0f), vec3(in_axis_y, 0.0f), vec3(in_translation, 1.0f));
 	gl_Position = vec4((projection_matrix * view_matrix * model_matrix * vec3(in_position_m, 1.0f)).xyz, 1.0f);
 }
\ No newline at end of file
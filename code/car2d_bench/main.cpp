@@ -0,0 +1,706 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <yaml-cpp/yaml.h>
+#include "car2d_sim/sim_config.hpp"
+#include "car2d_sim/car_batch.hpp"
+#include "car2d_sim/job_pool.hpp"
+#include "car2d_sim/road.hpp"
+#include "micro_bench.hpp"
+#include "scenario.hpp"
+
+/*
+	Benchmarks for the headless simulation. Run from the binary directory like car2d_main.
+*/
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+	int car_count;
+	int tick_count;
+	int max_threads;
+	std::string map_path;						// Write a generated map here instead of benchmarking.
+	int map_segment_count;
+	float map_tile_size;						// Split the generated map into tiles of this size, if positive (m).
+	bool micro_only;							// Only run the microbenchmarks.
+	bool equivalence_only;						// Only run the batch equivalence check.
+	MicroOptions micro;
+	std::string scenario_name;					// Only run this scenario, from assets/scenarios.
+	ScenarioOptions scenario;
+
+	Options()
+		: car_count(10000)
+		, tick_count(400)
+		, max_threads(static_cast<int>(std::thread::hardware_concurrency()))
+		, map_segment_count(10000)
+		, map_tile_size(0.0f)
+		, micro_only(false)
+		, equivalence_only(false)
+	{
+		if (max_threads <= 0)
+			max_threads = 1;
+	}
+};
+
+static unsigned long long hash_batch(const CarBatch& batch)
+{
+	// FNV-1a over the raw bits of the state, so any difference at all shows up.
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i = 0; i < batch.get_car_count(); ++i)
+	{
+		float values[] = { batch.get_position(i).x, batch.get_position(i).y, batch.get_orientation(i), batch.get_angular_velocity(i) };
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+		for (int k = 0; k < sizeof(values); ++k)
+		{
+			hash ^= bytes[k];
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+static void spawn_fleet(CarBatch& batch, int car_count)
+{
+	for (int i = 0; i < car_count; ++i)
+	{
+		batch.add_car(glm::vec2((i % 100) * 3.0f, (i / 100) * 6.0f), 90.0f * DEGREES_TO_RADIANS);
+
+		// Give every car its own line so the lanes diverge.
+		CarInput input;
+		input.throttle = true;
+		input.steer = std::sin(static_cast<float>(i));
+		input.toggle_automatic = (i % 2) == 0;
+		batch.handle_input(i, input);
+	}
+}
+
+/*
+	Step the same fleet with 1 to N threads and report ticks per second. Every run must end in exactly
+	the same state as the single threaded one.
+*/
+static bool bench_job_scaling(const CarDescription& description, const Options& options)
+{
+	std::cout << "Fleet scaling: " << options.car_count << " cars, " << options.tick_count << " ticks" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(14) << "ticks/s" << std::setw(10) << "speedup" << std::setw(12) << "identical" << std::endl;
+
+	bool identical = true;
+	double single_thread_rate = 0.0;
+	unsigned long long single_thread_hash = 0;
+	for (int thread_count = 1; thread_count <= options.max_threads; ++thread_count)
+	{
+		JobPool job_pool(thread_count);
+		CarBatch batch(description);
+		spawn_fleet(batch, options.car_count);
+
+		Clock::time_point start = Clock::now();
+		for (int tick = 0; tick < options.tick_count; ++tick)
+		{
+			batch.update(DT, job_pool);
+		}
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		double rate = options.tick_count / seconds;
+
+		unsigned long long hash = hash_batch(batch);
+		if (thread_count == 1)
+		{
+			single_thread_rate = rate;
+			single_thread_hash = hash;
+		}
+
+		bool same = hash == single_thread_hash;
+		identical = identical && same;
+		std::cout << std::setw(8) << thread_count << std::setw(14) << std::fixed << std::setprecision(1) << rate
+				  << std::setw(9) << std::setprecision(2) << rate / single_thread_rate << "x" << std::setw(12) << (same ? "yes" : "NO") << std::endl;
+	}
+
+	return identical;
+}
+
+/*
+	The tolerances of the batch equivalence check. The vectorized atan2/sin/cos are a couple of ulps off
+	the C library, which the scalar Car uses. That is enough to flip a slip flag near its threshold or
+	the sign of the yaw rate of a car barely moving, after which the cars drift apart, further the
+	longer they run; the tolerances hold for the EQUIVALENCE_TICK_COUNT ticks the check runs. Built
+	with CAR2D_BATCH_EXACT_MATH they must match exactly, for any number of ticks.
+*/
+static const int EQUIVALENCE_TICK_COUNT = 400;
+#ifdef CAR2D_BATCH_EXACT_MATH
+static const float EQUIVALENCE_POSITION_TOLERANCE = 0.0f;
+static const float EQUIVALENCE_ORIENTATION_TOLERANCE = 0.0f;
+static const float EQUIVALENCE_ANGULAR_VELOCITY_TOLERANCE = 0.0f;
+#else
+static const float EQUIVALENCE_POSITION_TOLERANCE = 0.5f;				// (m)
+static const float EQUIVALENCE_ORIENTATION_TOLERANCE = 0.02f;			// (rad)
+static const float EQUIVALENCE_ANGULAR_VELOCITY_TOLERANCE = 0.2f;		// (rad/s)
+#endif
+
+/* The input of a car for the given period of ticks: a deterministic mix of every control, presses included. */
+static CarInput equivalence_input(int car, int period)
+{
+	unsigned int bits = static_cast<unsigned int>(car) * 2654435761u ^ static_cast<unsigned int>(period + 1) * 40503u;
+	bits ^= bits >> 13;
+	bits *= 1274126177u;
+	bits ^= bits >> 16;
+
+	CarInput input;
+	input.throttle = (bits & 3) != 0;
+	input.reverse = (bits & 12) == 12;
+	input.ebrake = (bits & 48) == 48;
+	input.steer = static_cast<int>((bits >> 6) & 255) / 127.5f - 1.0f;
+	input.gear_up = (bits & (1 << 14)) != 0;
+	input.gear_down = (bits & (3 << 15)) == (3 << 15);
+	input.toggle_automatic = (bits & (1 << 17)) != 0;
+	return input;
+}
+
+/*
+	Step scalar Cars, the reference, side by side with a CarBatch of the same cars under the same
+	inputs, and compare their state after every tick. Stops at the first car out of tolerance.
+*/
+static bool bench_batch_equivalence(const YAML::Node& car_config, const YAML::Node& config)
+{
+	const int CAR_COUNT = 256;
+	const int INPUT_PERIOD = 50;				// Ticks between input changes.
+
+	Car prototype(car_config, config);
+	CarBatch batch(prototype.get_description());
+	std::vector<Car> cars(CAR_COUNT, prototype);
+	for (int i = 0; i < CAR_COUNT; ++i)
+	{
+		glm::vec2 position((i % 16) * 3.0f, (i / 16) * 6.0f);
+		float orientation = (90.0f + 5.0f * (i % 7)) * DEGREES_TO_RADIANS;
+		cars[i].place(position, orientation);
+		batch.add_car(position, orientation);
+	}
+
+#ifdef CAR2D_BATCH_EXACT_MATH
+	std::cout << "Batch equivalence: " << CAR_COUNT << " cars, " << EQUIVALENCE_TICK_COUNT << " ticks, exact" << std::endl;
+#else
+	std::cout << "Batch equivalence: " << CAR_COUNT << " cars, " << EQUIVALENCE_TICK_COUNT << " ticks, within " << EQUIVALENCE_POSITION_TOLERANCE << " m, "
+			  << EQUIVALENCE_ORIENTATION_TOLERANCE << " rad, " << EQUIVALENCE_ANGULAR_VELOCITY_TOLERANCE << " rad/s" << std::endl;
+#endif
+
+	float position_error = 0.0f;
+	float orientation_error = 0.0f;
+	float angular_velocity_error = 0.0f;
+	for (int tick = 0; tick < EQUIVALENCE_TICK_COUNT; ++tick)
+	{
+		if (tick % INPUT_PERIOD == 0)
+		{
+			for (int i = 0; i < CAR_COUNT; ++i)
+			{
+				CarInput input = equivalence_input(i, tick / INPUT_PERIOD);
+				cars[i].handle_input(input);
+				batch.handle_input(i, input);
+			}
+		}
+
+		for (int i = 0; i < CAR_COUNT; ++i)
+		{
+			cars[i].update(DT);
+		}
+		batch.update(DT);
+
+		for (int i = 0; i < CAR_COUNT; ++i)
+		{
+			float position = glm::length(cars[i].get_position() - batch.get_position(i));
+			float orientation = std::abs(cars[i].get_orientation() - batch.get_orientation(i));
+			float angular_velocity = std::abs(cars[i].get_angular_velocity() - batch.get_angular_velocity(i));
+			position_error = glm::max(position_error, position);
+			orientation_error = glm::max(orientation_error, orientation);
+			angular_velocity_error = glm::max(angular_velocity_error, angular_velocity);
+
+			if (position > EQUIVALENCE_POSITION_TOLERANCE || orientation > EQUIVALENCE_ORIENTATION_TOLERANCE
+				|| angular_velocity > EQUIVALENCE_ANGULAR_VELOCITY_TOLERANCE || cars[i].get_gear() != batch.get_gear(i))
+			{
+				std::cout << std::setprecision(9) << "Car " << i << " differs after tick " << tick + 1 << ":" << std::endl;
+				std::cout << std::setw(10) << "Car" << "  position (" << cars[i].get_position().x << ", " << cars[i].get_position().y << "), orientation "
+						  << cars[i].get_orientation() << ", angular velocity " << cars[i].get_angular_velocity() << ", gear " << cars[i].get_gear() << std::endl;
+				std::cout << std::setw(10) << "CarBatch" << "  position (" << batch.get_position(i).x << ", " << batch.get_position(i).y << "), orientation "
+						  << batch.get_orientation(i) << ", angular velocity " << batch.get_angular_velocity(i) << ", gear " << batch.get_gear(i) << std::endl;
+				std::cout << std::endl;
+				return false;
+			}
+		}
+	}
+
+	std::cout << std::setw(10) << "same" << "  largest difference " << std::scientific << std::setprecision(2) << position_error << " m, "
+			  << orientation_error << " rad, " << angular_velocity_error << " rad/s" << std::fixed << std::endl;
+	std::cout << std::endl;
+	return true;
+}
+
+/*
+	Compare the baked torque tables against the piecewise linear curve they were made from, both for
+	accuracy and for the cost of a lookup.
+*/
+static void bench_torque_lookup(const CarDescription& description)
+{
+	const int LOOKUP_COUNT = 1 << 22;
+	const int GEAR = 3;
+
+	std::cout << "Torque lookup: " << description.torque_tables[GEAR].torques.size() << " samples per gear, "
+			  << description.torque_table_step << " rpm apart, max error " << std::scientific << std::setprecision(3)
+			  << description.torque_table_error << " Nm" << std::fixed << std::endl;
+
+	// Sweep the whole curve and a bit beyond it on both sides.
+	float rpm_per_omega = ANGULAR_VELOCITY_TO_RPM * description.transmissions[GEAR];
+	float rpm_begin = description.torque_curve.front().x - 500.0f;
+	float rpm_end = description.torque_curve.back().x + 500.0f;
+	std::vector<float> omegas(LOOKUP_COUNT);
+	for (int i = 0; i < LOOKUP_COUNT; ++i)
+	{
+		omegas[i] = (rpm_begin + (rpm_end - rpm_begin) * static_cast<int>(i * 7919LL % LOOKUP_COUNT) / LOOKUP_COUNT) / rpm_per_omega;
+	}
+
+	double curve_sum = 0.0;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < LOOKUP_COUNT; ++i)
+	{
+		float transmission = description.gear_ratios[GEAR] * description.differential_ratio * description.transmission_efficiency;
+		curve_sum += lerp_curve(description.torque_curve, ANGULAR_VELOCITY_TO_RPM * omegas[i] * transmission) * transmission;
+	}
+	double curve_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	double table_sum = 0.0;
+	const TorqueTable& table = description.torque_tables[GEAR];
+	start = Clock::now();
+	for (int i = 0; i < LOOKUP_COUNT; ++i)
+	{
+		table_sum += table.lookup(omegas[i]);
+	}
+	double table_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << std::setw(10) << "curve" << std::setw(10) << std::setprecision(2) << curve_seconds * 1e9 / LOOKUP_COUNT << " ns/lookup" << std::endl;
+	std::cout << std::setw(10) << "table" << std::setw(10) << std::setprecision(2) << table_seconds * 1e9 / LOOKUP_COUNT << " ns/lookup"
+			  << " (sums differ by " << std::scientific << std::setprecision(1) << std::abs(curve_sum - table_sum) / std::abs(curve_sum) << std::fixed << ")" << std::endl;
+	std::cout << std::endl;
+}
+
+/*
+	The arc length code the road segments used before they had tables: march along the curve in 32
+	chords from t = 0 on every query. Kept here as the baseline.
+*/
+static const int LEGACY_SEGMENT_COUNT = 32;
+
+static float legacy_get_length(const RoadSegment& segment, float t)
+{
+	const float delta = 1.0f / LEGACY_SEGMENT_COUNT;
+	float length = 0.0f;
+	int chord = int(t * LEGACY_SEGMENT_COUNT);
+	for (int i = 0; i < chord; ++i)
+	{
+		length += glm::length(segment.get_position((i + 1) * delta) - segment.get_position(i * delta));
+	}
+
+	length += glm::length(segment.get_position((chord + 1) * delta) - segment.get_position(chord * delta)) * (t - chord * delta) * LEGACY_SEGMENT_COUNT;
+	return length;
+}
+
+static float legacy_get_parameter_at_distance(const RoadSegment& segment, float distance)
+{
+	const float delta = 1.0f / LEGACY_SEGMENT_COUNT;
+	float t = 0.0f;
+	float length = 0.0f;
+	while (true)
+	{
+		// Bounded at the end of the curve, unlike the original which relied on the curve extrapolating.
+		float chord_length = glm::length(segment.get_position(t + delta) - segment.get_position(t));
+		if (length + chord_length > distance || t + delta >= 1.0f)
+			break;
+		t += delta;
+		length += chord_length;
+	}
+
+	float chord_length = glm::length(segment.get_position(t + delta) - segment.get_position(t));
+	return t + delta * (distance - length) / chord_length;
+}
+
+/* The length up to t by brute force, in double precision. */
+static double reference_length(const RoadSegment& segment, float t)
+{
+	const int STEPS = 1 << 16;
+	double length = 0.0;
+	glm::dvec2 previous(segment.get_position(0.0f));
+	for (int i = 1; i <= STEPS; ++i)
+	{
+		glm::dvec2 position(segment.get_position(static_cast<float>(static_cast<double>(t) * i / STEPS)));
+		length += glm::length(position - previous);
+		previous = position;
+	}
+	return length;
+}
+
+template <typename Function>
+static double time_per_call(int count, const Function& function)
+{
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < count; ++i)
+	{
+		function(i);
+	}
+	return std::chrono::duration<double>(Clock::now() - start).count() / count;
+}
+
+/*
+	Time building and tessellating a long curve, and the individual distance and parameter queries,
+	against the 32 chord marching. Also report how far both are from the true length.
+*/
+template <typename Factory>
+static void bench_road_segment(const char* name, const Factory& create)
+{
+	const int QUERY_COUNT = 1 << 16;
+	const float STEP_LENGTH = 1.0f;
+	volatile float sink = 0.0f;
+
+	RoadSegment* segment = create();
+	float length = segment->get_length();
+
+	// Building the segment and its mesh.
+	double table_load = time_per_call(8, [&](int) {
+		RoadSegment* loaded = create();
+		std::vector<RoadVertex> vertices;
+		std::vector<unsigned int> indices;
+		loaded->tessellate(STEP_LENGTH, vertices, indices);
+		sink = sink + vertices.back().position.x;
+		delete loaded;
+	});
+	double legacy_load = time_per_call(8, [&](int) {
+		// The old tessellation did two parameter searches per step.
+		std::vector<glm::vec2> positions;
+		float legacy_length = legacy_get_length(*segment, 1.0f);
+		for (float distance = 0.0f; distance < legacy_length; distance += STEP_LENGTH)
+		{
+			positions.push_back(segment->get_position(legacy_get_parameter_at_distance(*segment, distance)));
+			positions.push_back(segment->get_position(legacy_get_parameter_at_distance(*segment, glm::min(distance + STEP_LENGTH, legacy_length))));
+		}
+		sink = sink + positions.back().x;
+	});
+
+	// Single queries at scattered positions.
+	double table_distance = time_per_call(QUERY_COUNT, [&](int i) { sink = sink + segment->get_parameter_at_distance(length * (i * 7919 % QUERY_COUNT) / QUERY_COUNT); });
+	double legacy_distance = time_per_call(QUERY_COUNT, [&](int i) { sink = sink + legacy_get_parameter_at_distance(*segment, length * (i * 7919 % QUERY_COUNT) / QUERY_COUNT); });
+	double table_length = time_per_call(QUERY_COUNT, [&](int i) { sink = sink + segment->get_length(static_cast<float>(i * 7919 % QUERY_COUNT) / QUERY_COUNT); });
+	double legacy_length = time_per_call(QUERY_COUNT, [&](int i) { sink = sink + legacy_get_length(*segment, static_cast<float>(i * 7919 % QUERY_COUNT) / QUERY_COUNT); });
+
+	// Accuracy of the length against the brute force reference.
+	double table_error = 0.0;
+	double legacy_error = 0.0;
+	for (int i = 1; i <= 16; ++i)
+	{
+		float t = i / 16.0f;
+		double reference = reference_length(*segment, t);
+		table_error = glm::max(table_error, std::abs(segment->get_length(t) - reference));
+		legacy_error = glm::max(legacy_error, std::abs(legacy_get_length(*segment, t) - reference));
+	}
+
+	std::cout << name << ", " << std::setprecision(1) << length << " m" << std::endl;
+	std::cout << std::setw(10) << "table" << std::setw(14) << std::setprecision(3) << table_load * 1e3 << std::setw(18) << std::setprecision(1) << table_distance * 1e9
+			  << std::setw(18) << table_length * 1e9 << std::setw(16) << std::setprecision(4) << table_error << std::endl;
+	std::cout << std::setw(10) << "legacy" << std::setw(14) << std::setprecision(3) << legacy_load * 1e3 << std::setw(18) << std::setprecision(1) << legacy_distance * 1e9
+			  << std::setw(18) << legacy_length * 1e9 << std::setw(16) << std::setprecision(4) << legacy_error << std::endl;
+
+	delete segment;
+}
+
+static RoadSegment* create_long_quadratic()
+{
+	return new RoadSegmentBezierQuadratic(glm::vec2(0.0f, 0.0f), glm::vec2(1000.0f, 2000.0f), glm::vec2(2000.0f, 0.0f));
+}
+
+static RoadSegment* create_long_cubic()
+{
+	return new RoadSegmentBezierCubic(glm::vec2(0.0f, 0.0f), glm::vec2(1500.0f, 0.0f), glm::vec2(0.0f, 1500.0f), glm::vec2(1500.0f, 1500.0f));
+}
+
+static RoadSegment* create_long_clothoid()
+{
+	// Straight into a tight turn, going through almost two full laps of heading.
+	return new RoadSegmentClothoid(glm::vec2(0.0f, 0.0f), 0.0f, 1000.0f, 0.0f, 0.02f);
+}
+
+static void bench_road_arc_length()
+{
+	std::cout << "Road arc length" << std::endl;
+	std::cout << std::setw(10) << "" << std::setw(14) << "load (ms)" << std::setw(18) << "distance->t (ns)" << std::setw(18) << "t->length (ns)" << std::setw(16) << "max error (m)" << std::endl;
+	bench_road_segment("Quadratic bezier", create_long_quadratic);
+	bench_road_segment("Cubic bezier", create_long_cubic);
+	bench_road_segment("Clothoid", create_long_clothoid);
+	std::cout << std::endl;
+}
+
+/* A small deterministic generator, so the same arguments always give the same map. */
+static float random_range(unsigned int& state, float low, float high)
+{
+	state = state * 1664525u + 1013904223u;
+	return low + (high - low) * ((state >> 8) / 16777216.0f);
+}
+
+static void write_vector(std::ostream& out, const char* key, const glm::vec2& v)
+{
+	out << "        " << key << ": [" << v.x << ", " << v.y << "]" << std::endl;
+}
+
+/* The segments of the generated map that start in one tile. */
+struct GeneratedTile
+{
+	std::ostringstream segments;
+	glm::vec2 bounds_min;
+	glm::vec2 bounds_max;
+};
+
+/*
+	Write a map with a long winding road of straights, clothoids and quadratic beziers, each starting
+	where the previous one ended. Used to test rendering and loading on maps far larger than the
+	hand made ones.
+
+	With a tile size, each segment goes to the tile its start is in, every tile is written next to the
+	map as <map>_<x>_<y>.yaml, and the map itself only lists the tiles.
+*/
+static void write_generated_map(const std::string& path, int segment_count, float tile_size)
+{
+	std::ofstream out(path.c_str());
+	if (!out)
+		throw std::runtime_error("Failed to open " + path + " for writing");
+
+	out << std::fixed << std::setprecision(5);
+	out << "GroundTexture: stk_generic_grassb.dds" << std::endl;
+	out << "GroundTextureScale: 0.1" << std::endl;
+	out << "RoadTexture: stktex_generic_earth_a.dds" << std::endl;
+
+	std::map<std::pair<int, int>, GeneratedTile> tiles;
+	unsigned int state = 12345;
+	glm::vec2 position(0.0f, -10.0f);
+	float heading = 90.0f * DEGREES_TO_RADIANS;
+	for (int i = 0; i < segment_count; ++i)
+	{
+		glm::vec2 direction(std::cos(heading), std::sin(heading));
+		RoadSegment* segment = nullptr;
+
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(5);
+		text << "    -" << std::endl;
+		switch (i % 3)
+		{
+			case 0:
+			{
+				glm::vec2 end = position + direction * random_range(state, 10.0f, 40.0f);
+				text << "        Type: Straight" << std::endl;
+				write_vector(text, "Start", position);
+				write_vector(text, "End", end);
+				segment = new RoadSegmentStraight(position, end);
+			} break;
+
+			case 1:
+			{
+				float length = random_range(state, 20.0f, 60.0f);
+				float end_curvature = random_range(state, -0.04f, 0.04f);
+				text << "        Type: Clothoid" << std::endl;
+				write_vector(text, "Start", position);
+				text << "        Heading: " << heading * RADIANS_TO_DEGREES << std::endl;
+				text << "        Length: " << length << std::endl;
+				text << "        StartCurvature: 0.0" << std::endl;
+				text << "        EndCurvature: " << end_curvature << std::endl;
+				segment = new RoadSegmentClothoid(position, heading, length, 0.0f, end_curvature);
+			} break;
+
+			case 2:
+			{
+				glm::vec2 control = position + direction * random_range(state, 10.0f, 30.0f);
+				float turn = heading + random_range(state, -0.8f, 0.8f);
+				glm::vec2 end = control + glm::vec2(std::cos(turn), std::sin(turn)) * random_range(state, 10.0f, 30.0f);
+				text << "        Type: BezierQuadratic" << std::endl;
+				write_vector(text, "Start", position);
+				write_vector(text, "Control", control);
+				write_vector(text, "End", end);
+				segment = new RoadSegmentBezierQuadratic(position, control, end);
+			} break;
+		}
+
+		text << "        Width: 3.0" << std::endl;
+		text << "        TextureScale: 0.1" << std::endl;
+		segment->road_width = 3.0f;
+
+		// Untiled maps are one tile.
+		std::pair<int, int> key(0, 0);
+		if (tile_size > 0.0f)
+			key = std::make_pair(static_cast<int>(std::floor(position.x / tile_size)), static_cast<int>(std::floor(position.y / tile_size)));
+
+		glm::vec2 bounds_min;
+		glm::vec2 bounds_max;
+		segment->get_bounds(Road::TESSELLATION_STEP, bounds_min, bounds_max);
+
+		std::map<std::pair<int, int>, GeneratedTile>::iterator tile = tiles.find(key);
+		if (tile == tiles.end())
+		{
+			tile = tiles.insert(std::make_pair(key, GeneratedTile())).first;
+			tile->second.bounds_min = bounds_min;
+			tile->second.bounds_max = bounds_max;
+		}
+		tile->second.segments << text.str();
+		tile->second.bounds_min = glm::min(tile->second.bounds_min, bounds_min);
+		tile->second.bounds_max = glm::max(tile->second.bounds_max, bounds_max);
+
+		// Continue from where the text says this segment ends, so rounding does not open gaps.
+		position = segment->get_position(1.0f);
+		position = glm::vec2(std::floor(position.x * 100000.0f + 0.5f) / 100000.0f, std::floor(position.y * 100000.0f + 0.5f) / 100000.0f);
+		glm::vec2 tangent = segment->get_tangent(1.0f);
+		heading = std::atan2(tangent.y, tangent.x);
+		delete segment;
+	}
+
+	if (tile_size <= 0.0f)
+	{
+		out << "Segments:" << std::endl;
+		if (!tiles.empty())
+			out << tiles.begin()->second.segments.str();
+
+		std::cout << "Wrote " << segment_count << " segments to " << path << std::endl;
+		return;
+	}
+
+	// The tiles are named after the map and referred to relative to its directory.
+	std::string::size_type slash = path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	std::string stem = path.substr(directory.size());
+	if (stem.size() > 5 && stem.compare(stem.size() - 5, 5, ".yaml") == 0)
+		stem.resize(stem.size() - 5);
+
+	out << "Tiles:" << std::endl;
+	for (std::map<std::pair<int, int>, GeneratedTile>::iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+	{
+		std::ostringstream file;
+		file << stem << "_" << tile->first.first << "_" << tile->first.second << ".yaml";
+
+		// Round the bounds outwards so the text still contains the segments.
+		out << "    -" << std::endl;
+		out << "        File: " << file.str() << std::endl;
+		out << "        Bounds: [" << std::floor(tile->second.bounds_min.x) << ", " << std::floor(tile->second.bounds_min.y) << ", "
+			<< std::ceil(tile->second.bounds_max.x) << ", " << std::ceil(tile->second.bounds_max.y) << "]" << std::endl;
+
+		std::ofstream tile_out((directory + file.str()).c_str());
+		if (!tile_out)
+			throw std::runtime_error("Failed to open " + directory + file.str() + " for writing");
+		tile_out << "Segments:" << std::endl;
+		tile_out << tile->second.segments.str();
+	}
+
+	std::cout << "Wrote " << segment_count << " segments in " << tiles.size() << " tiles to " << path << std::endl;
+}
+
+static void parse_arguments(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (i + 1 < argc && std::strcmp(argv[i], "--cars") == 0)
+			options.car_count = std::atoi(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--ticks") == 0)
+			options.tick_count = std::atoi(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--threads") == 0)
+			options.max_threads = std::atoi(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--write-map") == 0)
+			options.map_path = argv[++i];
+		else if (i + 1 < argc && std::strcmp(argv[i], "--map-segments") == 0)
+			options.map_segment_count = std::atoi(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--map-tile-size") == 0)
+			options.map_tile_size = static_cast<float>(std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--batch-equivalence") == 0)
+			options.equivalence_only = true;
+		else if (std::strcmp(argv[i], "--micro") == 0)
+			options.micro_only = true;
+		else if (i + 1 < argc && std::strcmp(argv[i], "--samples") == 0)
+			options.micro.sample_count = std::max(std::atoi(argv[++i]), 1);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--baseline") == 0)
+			options.micro.baseline_path = argv[++i];
+		else if (i + 1 < argc && std::strcmp(argv[i], "--write-baseline") == 0)
+			options.micro.write_baseline_path = argv[++i];
+		else if (i + 1 < argc && std::strcmp(argv[i], "--threshold") == 0)
+			options.micro.regression_threshold = std::atof(argv[++i]) / 100.0;
+		else if (i + 1 < argc && std::strcmp(argv[i], "--scenario") == 0)
+			options.scenario_name = argv[++i];
+		else if (i + 1 < argc && std::strcmp(argv[i], "--repeat") == 0)
+			options.scenario.repeat_count = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--write-golden") == 0)
+			options.scenario.write_golden = true;
+		else
+			throw std::runtime_error(std::string("Unknown argument: ") + argv[i]);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int result = 0;
+	try
+	{
+		Options options;
+		parse_arguments(argc, argv, options);
+
+		if (!options.map_path.empty())
+		{
+			write_generated_map(options.map_path, options.map_segment_count, options.map_tile_size);
+			return 0;
+		}
+
+		YAML::Node config = YAML::LoadFile(PROJECT_ROOT + FILE_CONFIG);
+		if (!options.scenario_name.empty())
+		{
+			if (!run_scenario(options.scenario_name, config, options.scenario))
+			{
+				std::cerr << "The scenario did not drive like its golden trace." << std::endl;
+				result = 1;
+			}
+			return result;
+		}
+
+		YAML::Node car_config = YAML::LoadFile(DIRECTORY_CARS + config["Assets"]["DefaultCar"].as<std::string>());
+		CarDescription description(car_config, config);
+
+		if (options.equivalence_only)
+		{
+			if (!bench_batch_equivalence(car_config, config))
+			{
+				std::cerr << "CarBatch no longer matches Car." << std::endl;
+				result = 1;
+			}
+			return result;
+		}
+
+		if (!run_micro_benchmarks(car_config, config, options.micro))
+		{
+			std::cerr << "Slower than the baseline." << std::endl;
+			result = 1;
+		}
+		if (options.micro_only)
+			return result;
+
+		bench_torque_lookup(description);
+		bench_road_arc_length();
+		if (!bench_batch_equivalence(car_config, config))
+		{
+			std::cerr << "CarBatch no longer matches Car." << std::endl;
+			result = 1;
+		}
+		if (!bench_job_scaling(description, options))
+		{
+			std::cerr << "Results differ between thread counts." << std::endl;
+			result = 1;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Exception caught: " << e.what() << std::endl;
+		result = 1;
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include "micro_bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include "car2d_sim/car.hpp"
+#include "car2d_sim/road.hpp"
+#include "car2d_sim/telemetry.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+struct MicroResult
+{
+	std::string name;
+	int calls_per_sample;
+	double median;								// (ns per call)
+	double deviation;							// The standard deviation of the samples (ns per call)
+};
+
+/*
+	Keep the benchmark on the core it started on, so it is not migrated between samples, and say how
+	well the clock can be trusted. The frequency itself can not be locked from a user program; on
+	Linux the governor is reported so an unsteady one can be fixed before comparing runs.
+*/
+static std::string pin_thread()
+{
+#ifdef _WIN32
+	if (SetThreadAffinityMask(GetCurrentThread(), 1) == 0)
+		return "not pinned";
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+	return "pinned to core 0";
+#else
+	int cpu = sched_getcpu();
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu < 0 ? 0 : cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		return "not pinned";
+
+	std::ostringstream text;
+	text << "pinned to core " << (cpu < 0 ? 0 : cpu);
+
+	std::ostringstream governor_path;
+	governor_path << "/sys/devices/system/cpu/cpu" << (cpu < 0 ? 0 : cpu) << "/cpufreq/scaling_governor";
+	std::ifstream governor_file(governor_path.str().c_str());
+	std::string governor;
+	if (governor_file >> governor)
+	{
+		text << ", cpufreq governor " << governor;
+		if (governor != "performance")
+			text << " (use performance for steadier results)";
+	}
+	return text.str();
+#endif
+}
+
+/* Spin for a while so the core leaves its idle clock before the first sample. */
+static void warm_up_cpu(double seconds)
+{
+	volatile double sink = 0.0;
+	Clock::time_point start = Clock::now();
+	while (std::chrono::duration<double>(Clock::now() - start).count() < seconds)
+	{
+		for (int i = 0; i < 10000; ++i)
+		{
+			sink = sink + std::sqrt(static_cast<double>(i));
+		}
+	}
+}
+
+template <typename Function>
+static double time_sample(int call_count, const Function& function)
+{
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < call_count; ++i)
+	{
+		function(i);
+	}
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/*
+	Find how many calls make a sample long enough to time reliably, then take the samples. The first
+	few are thrown away, as they also pay for cold caches and branch predictors.
+*/
+template <typename Function>
+static MicroResult measure(const char* name, const MicroOptions& options, const Function& function)
+{
+	const int DISCARDED_SAMPLES = 3;
+
+	int call_count = 1;
+	while (time_sample(call_count, function) < options.sample_seconds && call_count < (1 << 30))
+	{
+		call_count *= 2;
+	}
+
+	std::vector<double> samples;
+	for (int i = 0; i < DISCARDED_SAMPLES + options.sample_count; ++i)
+	{
+		double seconds = time_sample(call_count, function);
+		if (i >= DISCARDED_SAMPLES)
+			samples.push_back(seconds * 1e9 / call_count);
+	}
+
+	double mean = 0.0;
+	for (int i = 0; i < samples.size(); ++i)
+	{
+		mean += samples[i];
+	}
+	mean /= samples.size();
+
+	double variance = 0.0;
+	for (int i = 0; i < samples.size(); ++i)
+	{
+		variance += (samples[i] - mean) * (samples[i] - mean);
+	}
+	variance /= samples.size() > 1 ? samples.size() - 1 : 1;
+
+	std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+
+	MicroResult result;
+	result.name = name;
+	result.calls_per_sample = call_count;
+	result.median = samples[samples.size() / 2];
+	result.deviation = std::sqrt(variance);
+	return result;
+}
+
+/* Queries spread over the whole range, in an order that jumps around so nothing is predictable. */
+static std::vector<float> scattered(float low, float high)
+{
+	const int COUNT = 4096;
+	std::vector<float> values(COUNT);
+	for (int i = 0; i < COUNT; ++i)
+	{
+		values[i] = low + (high - low) * static_cast<float>(i * 7919 % COUNT) / COUNT;
+	}
+	return values;
+}
+
+static MicroResult measure_parameter_at_distance(const char* name, const RoadSegment& segment, const MicroOptions& options)
+{
+	std::vector<float> distances = scattered(0.0f, segment.get_length());
+	volatile float sink = 0.0f;
+	return measure(name, options, [&](int i) { sink = sink + segment.get_parameter_at_distance(distances[i & 4095]); });
+}
+
+static void write_baseline(const std::string& path, const std::vector<MicroResult>& results)
+{
+	std::ofstream out(path.c_str());
+	if (!out)
+		throw std::runtime_error("Failed to open " + path + " for writing");
+
+	out << std::fixed << std::setprecision(3);
+	out << "{" << std::endl;
+	out << "    \"benchmarks\": {" << std::endl;
+	for (int i = 0; i < results.size(); ++i)
+	{
+		out << "        \"" << results[i].name << "\": { \"median_ns\": " << results[i].median << ", \"deviation_ns\": " << results[i].deviation << " }"
+			<< (i + 1 < results.size() ? "," : "") << std::endl;
+	}
+	out << "    }" << std::endl;
+	out << "}" << std::endl;
+
+	if (!out)
+		throw std::runtime_error("Failed to write " + path);
+	std::cout << "Wrote the baseline to " << path << std::endl;
+}
+
+/* Read the medians of a baseline. It is JSON, which yaml-cpp reads as well. */
+static std::map<std::string, double> read_baseline(const std::string& path)
+{
+	std::ifstream file(path.c_str());
+	if (!file)
+		throw std::runtime_error("Failed to open baseline " + path);
+
+	std::map<std::string, double> medians;
+	YAML::Node benchmarks = YAML::Load(file)["benchmarks"];
+	for (YAML::const_iterator it = benchmarks.begin(); it != benchmarks.end(); ++it)
+	{
+		medians[it->first.as<std::string>()] = it->second["median_ns"].as<double>();
+	}
+	return medians;
+}
+
+bool run_micro_benchmarks(const YAML::Node& car_config, const YAML::Node& config, const MicroOptions& options)
+{
+	std::map<std::string, double> baseline;
+	if (!options.baseline_path.empty())
+		baseline = read_baseline(options.baseline_path);
+
+	std::cout << "Microbenchmarks: " << pin_thread() << std::endl;
+	warm_up_cpu(0.5);
+
+	std::vector<MicroResult> results;
+
+	// One physics step of a car going round in circles, settled at speed so every force is in play.
+	{
+		Car car(car_config, config);
+		CarInput input;
+		input.throttle = true;
+		input.steer = 0.3f;
+		car.handle_input(input);
+		for (int i = 0; i < 4000; ++i)
+		{
+			car.update(DT);
+		}
+		results.push_back(measure("car update", options, [&](int) { car.update(DT); }));
+	}
+
+	// The torque curve lookup the tables replaced, still used wherever the exact curve is wanted.
+	{
+		CarDescription description(car_config, config);
+		std::vector<float> rpms = scattered(description.torque_curve.front().x - 500.0f, description.torque_curve.back().x + 500.0f);
+		volatile float sink = 0.0f;
+		results.push_back(measure("lerp_curve", options, [&](int i) { sink = sink + lerp_curve(description.torque_curve, rpms[i & 4095]); }));
+
+		// The baked table the physics step looks the torque up in, in first gear, from below the curve to above it.
+		const TorqueTable& table = description.torque_tables[description.torque_tables.size() > 1 ? 1 : 0];
+		float omega_range = table.inverse_step != 0.0f ? table.last_index / table.inverse_step : 1.0f;
+		std::vector<float> omegas = scattered(table.omega_min - 0.1f * omega_range, table.omega_min + 1.1f * omega_range);
+		results.push_back(measure("torque table lookup", options, [&](int i) { sink = sink + table.lookup(omegas[i & 4095]); }));
+	}
+
+	// The parameter search of each segment type, on segments long enough to make it work.
+	{
+		RoadSegmentStraight straight(glm::vec2(0.0f, 0.0f), glm::vec2(1000.0f, 500.0f));
+		RoadSegmentBezierQuadratic quadratic(glm::vec2(0.0f, 0.0f), glm::vec2(1000.0f, 2000.0f), glm::vec2(2000.0f, 0.0f));
+		RoadSegmentBezierCubic cubic(glm::vec2(0.0f, 0.0f), glm::vec2(1500.0f, 0.0f), glm::vec2(0.0f, 1500.0f), glm::vec2(1500.0f, 1500.0f));
+		RoadSegmentClothoid clothoid(glm::vec2(0.0f, 0.0f), 0.0f, 1000.0f, 0.0f, 0.02f);
+		RoadSegmentArc arc(glm::vec2(0.0f, 0.0f), glm::vec2(500.0f, 0.0f), glm::vec2(0.0f, 500.0f));
+		results.push_back(measure_parameter_at_distance("straight parameter at distance", straight, options));
+		results.push_back(measure_parameter_at_distance("quadratic parameter at distance", quadratic, options));
+		results.push_back(measure_parameter_at_distance("cubic parameter at distance", cubic, options));
+		results.push_back(measure_parameter_at_distance("clothoid parameter at distance", clothoid, options));
+		results.push_back(measure_parameter_at_distance("arc parameter at distance", arc, options));
+
+		// Building the mesh of a whole segment, into arrays that already have room as they would on reload.
+		std::vector<RoadVertex> vertices;
+		std::vector<unsigned int> indices;
+		volatile float sink = 0.0f;
+		results.push_back(measure("cubic tessellate", options, [&](int) {
+			vertices.clear();
+			indices.clear();
+			cubic.tessellate(Road::TESSELLATION_STEP, vertices, indices);
+			sink = sink + vertices.back().position.x;
+		}));
+	}
+
+	// Formatting every channel of a car, as the overlay does each frame before laying out the lines that changed.
+	{
+		Telemetry telemetry;
+		Car car(car_config, config);
+		car.set_telemetry(&telemetry);
+		car.update(DT);
+
+		volatile int sink = 0;
+		results.push_back(measure("telemetry format", options, [&](int) {
+			char buffer[256];
+			for (int k = 0; k < telemetry.get_channel_count(); ++k)
+			{
+				sink = sink + telemetry.format(k, buffer, sizeof(buffer));
+			}
+		}));
+		car.set_telemetry(nullptr);
+	}
+
+	bool regressed = false;
+	std::cout << std::setw(34) << std::left << "" << std::right << std::setw(14) << "median (ns)" << std::setw(14) << "stddev (ns)"
+			  << std::setw(10) << "calls" << std::setw(16) << "baseline (ns)" << std::setw(10) << "change" << std::endl;
+	for (int i = 0; i < results.size(); ++i)
+	{
+		const MicroResult& result = results[i];
+		std::cout << std::setw(34) << std::left << result.name << std::right << std::fixed << std::setprecision(2)
+				  << std::setw(14) << result.median << std::setw(14) << result.deviation << std::setw(10) << result.calls_per_sample;
+
+		std::map<std::string, double>::const_iterator base = baseline.find(result.name);
+		if (base != baseline.end())
+		{
+			double change = result.median / base->second - 1.0;
+			bool regression = change > options.regression_threshold;
+			regressed = regressed || regression;
+			std::cout << std::setw(16) << base->second << std::setw(9) << std::showpos << std::setprecision(1) << change * 100.0 << std::noshowpos << "%"
+					  << (regression ? "  REGRESSION" : "");
+		}
+		std::cout << std::endl;
+	}
+	std::cout << std::endl;
+
+	if (!options.write_baseline_path.empty())
+		write_baseline(options.write_baseline_path, results);
+
+	return !regressed;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+struct MicroOptions
+{
+	int sample_count;
+	double sample_seconds;						// Calls per sample are raised until a sample takes at least this long.
+	double regression_threshold;				// How much slower than the baseline median counts as a regression (fraction).
+	std::string baseline_path;					// Compare against this baseline, if set.
+	std::string write_baseline_path;			// Write the results as a new baseline, if set.
+
+	MicroOptions()
+		: sample_count(31)
+		, sample_seconds(0.002)
+		, regression_threshold(0.1)
+	{
+
+	}
+};
+
+/*
+	Time the hot paths of the simulation one call at a time: the car physics step, the torque table
+	lookup it uses and the curve lookup the tables replaced, the parameter search of every road segment
+	type, road tessellation and formatting the telemetry for the overlay.
+
+	The thread is pinned to one core and the CPU is kept busy for a moment first so it settles on a
+	clock, then every benchmark is sampled many times and the median and spread of the time per call
+	are reported. The results can be written as a JSON baseline and later runs compared against it;
+	any benchmark whose median is more than the threshold slower than in the baseline is flagged.
+	Returns false if any was.
+
+	Usage:
+
+	car2d_bench --micro --write-baseline bench_baseline.json
+	... change something ...
+	car2d_bench --micro --baseline bench_baseline.json
+*/
+bool run_micro_benchmarks(const YAML::Node& car_config, const YAML::Node& config, const MicroOptions& options);
\ No newline at end of file
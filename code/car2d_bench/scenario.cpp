@@ -0,0 +1,252 @@
+#include "scenario.hpp"
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include "car2d_sim/car.hpp"
+#include "car2d_sim/stat_file.hpp"
+#include "car2d_sim/stat_reader.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+/* The whole input from one tick on. Presses only act on that tick. */
+struct InputChange
+{
+	int tick;
+	CarInput input;
+};
+
+struct TraceSample
+{
+	int tick;
+	glm::vec2 position;
+	glm::vec2 velocity;
+	float orientation;
+	int gear;
+};
+
+/* Turn the events into the input to hand the car on each tick it changes. */
+static void parse_events(const YAML::Node& events, std::vector<InputChange>& changes)
+{
+	// Sort the indices rather than the nodes, as assigning a node overwrites what it refers to.
+	std::vector<std::pair<float, int> > sorted;
+	for (int i = 0; i < events.size(); ++i)
+	{
+		sorted.push_back(std::make_pair(events[i]["Time"].as<float>(), i));
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first < b.first; });
+
+	CarInput levels;
+	for (int i = 0; i < sorted.size(); ++i)
+	{
+		const YAML::Node event = events[sorted[i].second];
+		int tick = static_cast<int>(std::ceil(sorted[i].first / DT - 0.001f));
+
+		if (event["Throttle"])
+			levels.throttle = event["Throttle"].as<bool>();
+		if (event["Reverse"])
+			levels.reverse = event["Reverse"].as<bool>();
+		if (event["EBrake"])
+			levels.ebrake = event["EBrake"].as<bool>();
+		if (event["Steer"])
+			levels.steer = glm::clamp(event["Steer"].as<float>(), -1.0f, 1.0f);
+
+		// Events on the same tick are merged into one change.
+		if (changes.empty() || changes.back().tick != tick)
+		{
+			InputChange change;
+			change.tick = tick;
+			changes.push_back(change);
+		}
+
+		CarInput& input = changes.back().input;
+		bool gear_up = input.gear_up || (event["GearUp"] && event["GearUp"].as<bool>());
+		bool gear_down = input.gear_down || (event["GearDown"] && event["GearDown"].as<bool>());
+		bool toggle_automatic = input.toggle_automatic || (event["ToggleAutomatic"] && event["ToggleAutomatic"].as<bool>());
+		input = levels;
+		input.gear_up = gear_up;
+		input.gear_down = gear_down;
+		input.toggle_automatic = toggle_automatic;
+	}
+}
+
+static void sample(const Car& car, int tick, std::vector<TraceSample>& trace)
+{
+	TraceSample sample;
+	sample.tick = tick;
+	sample.position = car.get_position();
+	sample.velocity = car.get_velocity();
+	sample.orientation = car.get_orientation();
+	sample.gear = car.get_gear();
+	trace.push_back(sample);
+}
+
+/* Drive a copy of the car through the whole scenario. */
+static void drive(const Car& start, const std::vector<InputChange>& changes, int tick_count, int trace_ticks, std::vector<TraceSample>& trace)
+{
+	Car car(start);
+	trace.clear();
+	sample(car, 0, trace);
+
+	int next_change = 0;
+	for (int tick = 0; tick < tick_count; ++tick)
+	{
+		while (next_change < changes.size() && changes[next_change].tick <= tick)
+		{
+			car.handle_input(changes[next_change++].input);
+		}
+
+		car.update(DT);
+		if ((tick + 1) % trace_ticks == 0)
+			sample(car, tick + 1, trace);
+	}
+}
+
+static void write_golden(const std::string& path, const std::vector<TraceSample>& trace)
+{
+	StatFile file(path, STAT_FORMAT_COLUMNS);
+	int tick = file.add_column("tick", STAT_INT);
+	int time = file.add_column("time", STAT_DOUBLE);
+	int position_x = file.add_column("position_x", STAT_FLOAT);
+	int position_y = file.add_column("position_y", STAT_FLOAT);
+	int velocity_x = file.add_column("velocity_x", STAT_FLOAT);
+	int velocity_y = file.add_column("velocity_y", STAT_FLOAT);
+	int orientation = file.add_column("orientation", STAT_FLOAT);
+	int gear = file.add_column("gear", STAT_INT);
+	file.start();
+
+	for (int i = 0; i < trace.size(); ++i)
+	{
+		StatRow row;
+		row.set(tick, trace[i].tick);
+		row.set(time, static_cast<double>(trace[i].tick) * DT);
+		row.set(position_x, trace[i].position.x);
+		row.set(position_y, trace[i].position.y);
+		row.set(velocity_x, trace[i].velocity.x);
+		row.set(velocity_y, trace[i].velocity.y);
+		row.set(orientation, trace[i].orientation);
+		row.set(gear, trace[i].gear);
+		file.push_wait(row);
+	}
+
+	file.close();
+	std::cout << "Wrote " << trace.size() << " samples to " << path << std::endl;
+}
+
+static void read_golden_column(const StatReader& reader, const char* name, std::vector<float>& values)
+{
+	int column = reader.find_column(name);
+	if (column < 0)
+		throw std::runtime_error(std::string("The golden trace has no column ") + name);
+
+	values.resize(static_cast<size_t>(reader.get_row_count()));
+	if (!values.empty())
+		reader.read_column(column, 0, reader.get_chunk_count(), &values[0]);
+}
+
+/* Compare the trace against the golden one and report the largest differences. Returns false if any is outside its tolerance. */
+static bool compare_golden(const std::string& path, const std::vector<TraceSample>& trace, const YAML::Node& tolerance)
+{
+	float position_tolerance = tolerance["Position"].as<float>();
+	float velocity_tolerance = tolerance["Velocity"].as<float>();
+	float orientation_tolerance = tolerance["Orientation"].as<float>();
+
+	StatReader reader;
+	reader.open(path);
+	std::vector<float> ticks, position_x, position_y, velocity_x, velocity_y, orientation, gear;
+	read_golden_column(reader, "tick", ticks);
+	read_golden_column(reader, "position_x", position_x);
+	read_golden_column(reader, "position_y", position_y);
+	read_golden_column(reader, "velocity_x", velocity_x);
+	read_golden_column(reader, "velocity_y", velocity_y);
+	read_golden_column(reader, "orientation", orientation);
+	read_golden_column(reader, "gear", gear);
+
+	if (ticks.size() != trace.size())
+	{
+		std::cout << std::setw(10) << "trace" << "  " << trace.size() << " samples, the golden trace has " << ticks.size() << ": DIFFERENT" << std::endl;
+		return false;
+	}
+
+	float position_error = 0.0f;
+	float velocity_error = 0.0f;
+	float orientation_error = 0.0f;
+	int gear_mismatch_count = 0;
+	int first_failure = -1;
+	for (int i = 0; i < trace.size(); ++i)
+	{
+		if (static_cast<int>(ticks[i]) != trace[i].tick)
+			throw std::runtime_error("The golden trace " + path + " was sampled on other ticks, write it again with --write-golden");
+
+		float position = glm::length(trace[i].position - glm::vec2(position_x[i], position_y[i]));
+		float velocity = glm::length(trace[i].velocity - glm::vec2(velocity_x[i], velocity_y[i]));
+		float heading = std::abs(trace[i].orientation - orientation[i]);
+		position_error = glm::max(position_error, position);
+		velocity_error = glm::max(velocity_error, velocity);
+		orientation_error = glm::max(orientation_error, heading);
+		bool gear_mismatch = static_cast<int>(gear[i]) != trace[i].gear;
+		gear_mismatch_count += gear_mismatch ? 1 : 0;
+
+		// The gear has no tolerance, a drive in another gear is another drive.
+		if (first_failure < 0 && (position > position_tolerance || velocity > velocity_tolerance || heading > orientation_tolerance || gear_mismatch))
+			first_failure = i;
+	}
+
+	std::cout << std::setw(10) << "trace" << "  " << trace.size() << " samples, largest difference " << std::setprecision(6) << position_error << " m, "
+			  << velocity_error << " m/s, " << orientation_error << " rad, " << gear_mismatch_count << " in another gear" << std::endl;
+	if (first_failure >= 0)
+	{
+		std::cout << std::setw(10) << "" << "  OUTSIDE TOLERANCE from " << std::setprecision(2) << trace[first_failure].tick * DT << " s" << std::endl;
+		return false;
+	}
+
+	std::cout << std::setw(10) << "" << "  within tolerance" << std::endl;
+	return true;
+}
+
+bool run_scenario(const std::string& name, const YAML::Node& config, const ScenarioOptions& options)
+{
+	YAML::Node scenario = YAML::LoadFile(DIRECTORY_SCENARIOS + name);
+	std::string car_name = scenario["Car"].as<std::string>();
+	float duration = scenario["Duration"].as<float>();
+	int repeat_count = options.repeat_count > 0 ? options.repeat_count : scenario["Repeat"].as<int>();
+	if (repeat_count < 1)
+		throw std::runtime_error("The scenario " + name + " has to be run at least once, Repeat must be 1 or more");
+	int tick_count = static_cast<int>(std::ceil(duration / DT - 0.001f));
+	int trace_ticks = std::max(static_cast<int>(scenario["TraceInterval"].as<float>() / DT + 0.5f), 1);
+
+	Car car(YAML::LoadFile(DIRECTORY_CARS + car_name), config);
+
+	std::vector<InputChange> changes;
+	parse_events(scenario["Events"], changes);
+
+	std::cout << "Scenario " << name << ": " << car_name << ", " << std::fixed << std::setprecision(1) << duration << " s, "
+			  << changes.size() << " input changes, " << repeat_count << " runs" << std::endl;
+
+	std::vector<TraceSample> trace;
+	std::vector<double> rates;
+	for (int i = 0; i < repeat_count; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		drive(car, changes, tick_count, trace_ticks, trace);
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		rates.push_back(tick_count * DT / seconds);
+	}
+
+	std::sort(rates.begin(), rates.end());
+	double median = rates[rates.size() / 2];
+	std::cout << std::setw(10) << "speed" << "  " << std::setprecision(0) << median << " simulated s per s (" << rates.front() << " to " << rates.back()
+			  << "), " << median / DT << " ticks/s" << std::endl;
+
+	std::string golden_path = DIRECTORY_SCENARIOS + scenario["Golden"].as<std::string>();
+	if (options.write_golden)
+	{
+		write_golden(golden_path, trace);
+		return true;
+	}
+
+	return compare_golden(golden_path, trace, scenario["Tolerance"]);
+}
\ No newline at end of file
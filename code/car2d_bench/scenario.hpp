@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <yaml-cpp/yaml.h>
+
+struct ScenarioOptions
+{
+	int repeat_count;							// Run the scenario this many times for the timing, 0 to use the count in the file.
+	bool write_golden;							// Write the trace as the new golden trace instead of comparing against it.
+
+	ScenarioOptions()
+		: repeat_count(0)
+		, write_golden(false)
+	{
+
+	}
+};
+
+/*
+	Drive a car through a scripted scenario as fast as it will go, and check that it drove the same
+	way as when the golden trace was recorded.
+
+	A scenario names a car and lists timed input events. Throttle, Reverse, EBrake and Steer
+	keep their value until the next event changes them; GearUp, GearDown and ToggleAutomatic are
+	presses that act on the tick of the event only. Events are applied on the first tick at or after
+	their time.
+
+	The whole drive is run repeat times, each from the same start, and the median simulated seconds
+	per wall clock second is reported. The state of the car is sampled every TraceInterval seconds and
+	compared against the golden trace, a stat file next to the scenario (see car2d_sim/stat_file.hpp),
+	with the tolerances of the scenario. The gear has none, it must always match. The drive is on open
+	ground, as nothing in the physics depends on the road.
+
+	Returns false if the trace is outside the tolerances.
+
+	Usage (assets/scenarios/test_drive.yaml):
+
+	Car: test_car.yaml
+	Duration: 30.0
+	Repeat: 20
+	TraceInterval: 0.05
+	Golden: test_drive.c2dstat
+	Tolerance:
+		Position: 0.05
+		Velocity: 0.05
+		Orientation: 0.005
+	Events:
+		- { Time: 0.0, Throttle: true, ToggleAutomatic: true }
+		- { Time: 4.0, Steer: 0.5 }
+
+	car2d_bench --scenario test_drive.yaml --write-golden
+	car2d_bench --scenario test_drive.yaml
+*/
+bool run_scenario(const std::string& name, const YAML::Node& config, const ScenarioOptions& options);
\ No newline at end of file
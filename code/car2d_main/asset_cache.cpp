@@ -0,0 +1,396 @@
+#include "asset_cache.hpp"
+#include "shader.hpp"
+#include "car2d_sim/mapped_file.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+/* The start of a .progbin file, followed by the program binary. */
+struct ProgramBinaryHeader
+{
+	char magic[4];
+	unsigned long long key;						// FNV-1a of both sources and the driver.
+	unsigned int format;
+	unsigned int size;
+};
+
+static const char PROGRAM_BINARY_MAGIC[4] = { 'C', '2', 'P', 'B' };
+
+static unsigned long long hash_string(unsigned long long hash, const std::string& s)
+{
+	// Hash the terminator too, so the strings can not run into each other.
+	for (size_t i = 0; i <= s.size(); ++i)
+	{
+		hash ^= static_cast<unsigned char>(s.c_str()[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static std::string get_program_binary_path(const std::string& vs_path, const std::string& fs_path)
+{
+	std::string vs_stem = vs_path.substr(0, vs_path.find_last_of('.'));
+	std::string fs_stem = fs_path.substr(0, fs_path.find_last_of('.'));
+	if (vs_stem == fs_stem)
+		return vs_stem + ".progbin";
+
+	size_t slash = fs_stem.find_last_of("/\\");
+	return vs_stem + "_" + (slash == std::string::npos ? fs_stem : fs_stem.substr(slash + 1)) + ".progbin";
+}
+
+AssetRequest::AssetRequest(AssetType type, const std::string& path)
+	: type(type)
+	, path(path)
+{
+
+}
+
+AssetCache::AssetCache(int thread_count, const std::vector<AssetRequest>& requests)
+	: creation_time(Clock::now())
+	, stopping(false)
+{
+	if (thread_count <= 0)
+		thread_count = static_cast<int>(std::thread::hardware_concurrency());
+	if (thread_count <= 0)
+		thread_count = 1;
+
+	for (int i = 0; i < requests.size(); ++i)
+	{
+		request(requests[i].type, requests[i].path);
+	}
+
+	for (int i = 0; i < thread_count; ++i)
+	{
+		threads.push_back(std::thread(&AssetCache::worker_main, this, i + 1));
+	}
+}
+
+AssetCache::~AssetCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_condition.notify_all();
+
+	for (int i = 0; i < threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+
+	for (std::map<std::string, Program>::iterator it = programs.begin(); it != programs.end(); ++it)
+	{
+		glDeleteProgram(it->second.program);
+	}
+
+	for (std::map<std::string, Asset*>::iterator it = assets.begin(); it != assets.end(); ++it)
+	{
+		Asset* asset = it->second;
+		if (asset->gl_object != 0)
+			glDeleteTextures(1, &asset->gl_object);
+
+		delete asset->map;
+		delete asset;
+	}
+}
+
+void AssetCache::request(AssetType type, const std::string& path)
+{
+	std::map<std::string, Asset*>::iterator it = assets.find(path);
+	if (it != assets.end())
+	{
+		if (it->second->type != type)
+			throw std::runtime_error("Asset " + path + " was requested as two different types");
+		return;
+	}
+
+	Asset* asset = new Asset();
+	asset->type = type;
+	asset->path = path;
+	asset->started = false;
+	asset->finished = false;
+	asset->map = nullptr;
+	asset->gl_object = 0;
+	asset->queued_time = get_time();
+	asset->start_time = 0.0f;
+	asset->finish_time = 0.0f;
+	asset->upload_time = 0.0f;
+	asset->loaded_by = 0;
+	assets[path] = asset;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(asset);
+	}
+	work_condition.notify_one();
+}
+
+const std::string& AssetCache::get_text(const std::string& path)
+{
+	return wait(ASSET_TEXT, path).text;
+}
+
+const YAML::Node& AssetCache::get_yaml(const std::string& path)
+{
+	return wait(ASSET_YAML, path).yaml;
+}
+
+Map& AssetCache::get_map(const std::string& path)
+{
+	return *wait(ASSET_MAP, path).map;
+}
+
+GLuint AssetCache::get_texture(const std::string& path)
+{
+	Asset& asset = wait(ASSET_IMAGE, path);
+	if (asset.gl_object != 0)
+		return asset.gl_object;
+
+	float upload_start = get_time();
+	glGenTextures(1, &asset.gl_object);
+	glBindTexture(GL_TEXTURE_2D, asset.gl_object);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, asset.image.dimensions(0).x, asset.image.dimensions(0).y, 0, GL_BGR, GL_UNSIGNED_BYTE, asset.image.data());
+	asset.upload_time = get_time() - upload_start;
+
+	// The pixels live on in the texture.
+	asset.image = gli::storage();
+	return asset.gl_object;
+}
+
+GLuint AssetCache::get_program(const std::string& vs_path, const std::string& fs_path)
+{
+	std::string binary_path = get_program_binary_path(vs_path, fs_path);
+	std::map<std::string, Program>::iterator it = programs.find(binary_path);
+	if (it != programs.end())
+		return it->second.program;
+
+	const std::string& vs_source = get_text(vs_path);
+	const std::string& fs_source = get_text(fs_path);
+
+	float link_start = get_time();
+	if (driver.empty())
+	{
+		driver = std::string(reinterpret_cast<const char*>(glGetString(GL_VENDOR))) + " / "
+			+ reinterpret_cast<const char*>(glGetString(GL_RENDERER)) + " / "
+			+ reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	}
+
+	unsigned long long key = 14695981039346656037ULL;
+	key = hash_string(key, vs_source);
+	key = hash_string(key, fs_source);
+	key = hash_string(key, driver);
+
+	Program entry;
+	entry.name = binary_path;
+	entry.program = 0;
+
+	// Use the cached binary if it was made from these sources by this driver.
+	MappedFile binary_file;
+	if (binary_file.open(binary_path) && binary_file.get_size() >= sizeof(ProgramBinaryHeader))
+	{
+		ProgramBinaryHeader header;
+		std::memcpy(&header, binary_file.get_data(), sizeof(header));
+		if (std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) == 0
+			&& header.key == key
+			&& header.size == binary_file.get_size() - sizeof(header))
+		{
+			entry.program = load_program_binary(header.format, binary_file.get_data() + sizeof(header), header.size);
+		}
+	}
+	binary_file.close();
+	entry.from_binary = entry.program != 0;
+
+	if (!entry.from_binary)
+	{
+		GLuint vs = compile_shader(vs_path, GL_VERTEX_SHADER);
+		GLuint fs = compile_shader(fs_path, GL_FRAGMENT_SHADER);
+		entry.program = glCreateProgram();
+		glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(entry.program, vs);
+		glAttachShader(entry.program, fs);
+		try
+		{
+			link_program(entry.program);
+		}
+		catch (std::runtime_error& e)
+		{
+			glDeleteProgram(entry.program);
+			glDeleteShader(vs);
+			glDeleteShader(fs);
+			throw std::runtime_error(std::string("[") + binary_path + "] " + e.what());
+		}
+		glDetachShader(entry.program, vs);
+		glDetachShader(entry.program, fs);
+		glDeleteShader(vs);
+		glDeleteShader(fs);
+
+		// Save the binary for the next run. Failing to, e.g. in a read only install, only costs the compile.
+		GLenum format;
+		std::vector<char> binary;
+		if (get_program_binary(entry.program, format, binary))
+		{
+			ProgramBinaryHeader header;
+			std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+			header.key = key;
+			header.format = format;
+			header.size = static_cast<unsigned int>(binary.size());
+
+			std::ofstream file(binary_path.c_str(), std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(&binary[0], binary.size());
+		}
+	}
+
+	entry.link_time = get_time() - link_start;
+	programs[binary_path] = entry;
+	return entry.program;
+}
+
+void AssetCache::print_timeline(std::ostream& out) const
+{
+	static const char* TYPE_NAMES[] = { "text", "yaml", "image", "map" };
+
+	// List the assets in the order they finished loading.
+	std::vector<const Asset*> sorted;
+	for (std::map<std::string, Asset*>::const_iterator it = assets.begin(); it != assets.end(); ++it)
+	{
+		sorted.push_back(it->second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Asset* a, const Asset* b) { return a->finish_time < b->finish_time; });
+
+	out << "Asset timeline (ms): queued, started, loaded, upload time" << std::endl;
+	float total_load_time = 0.0f;
+	float last_finish_time = 0.0f;
+	for (int i = 0; i < sorted.size(); ++i)
+	{
+		const Asset& asset = *sorted[i];
+		out << std::fixed << std::setprecision(1)
+			<< std::setw(8) << asset.queued_time
+			<< std::setw(8) << asset.start_time
+			<< std::setw(8) << asset.finish_time
+			<< std::setw(8) << asset.upload_time
+			<< "  " << std::setw(5) << TYPE_NAMES[asset.type]
+			<< "  " << asset.path << " (thread " << asset.loaded_by << ")" << std::endl;
+
+		total_load_time += asset.finish_time - asset.start_time;
+		last_finish_time = std::max(last_finish_time, asset.finish_time);
+	}
+	out << "Loaded " << sorted.size() << " assets by " << last_finish_time << " ms, " << total_load_time << " ms of loading in total" << std::endl;
+
+	out << "Programs (ms): link or load time" << std::endl;
+	for (std::map<std::string, Program>::const_iterator it = programs.begin(); it != programs.end(); ++it)
+	{
+		const Program& program = it->second;
+		out << std::setw(8) << program.link_time << "  " << (program.from_binary ? "binary  " : "compiled")
+			<< "  " << program.name << std::endl;
+	}
+}
+
+AssetCache::Asset& AssetCache::wait(AssetType type, const std::string& path)
+{
+	request(type, path);
+	Asset& asset = *assets[path];
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!asset.started)
+	{
+		// No worker has got to it, so load it here rather than wait for one.
+		queue.erase(std::find(queue.begin(), queue.end(), &asset));
+		asset.started = true;
+		lock.unlock();
+
+		load(asset, 0);
+
+		lock.lock();
+		asset.finished = true;
+	}
+
+	finished_condition.wait(lock, [&asset] { return asset.finished; });
+	if (!asset.error.empty())
+		throw std::runtime_error(asset.error);
+
+	return asset;
+}
+
+void AssetCache::load(Asset& asset, int thread)
+{
+	asset.start_time = get_time();
+	asset.loaded_by = thread;
+	try
+	{
+		switch (asset.type)
+		{
+			case ASSET_TEXT:
+			{
+				std::ifstream file(asset.path.c_str());
+				if (!file.is_open())
+					throw std::runtime_error("Failed to open file");
+
+				std::ostringstream text;
+				text << file.rdbuf();
+				asset.text = text.str();
+			} break;
+
+			case ASSET_YAML:
+				asset.yaml = YAML::LoadFile(asset.path);
+				break;
+
+			case ASSET_IMAGE:
+				asset.image = gli::load_dds(asset.path.c_str());
+				if (asset.image.empty())
+					throw std::runtime_error("Failed to load image");
+				break;
+
+			case ASSET_MAP:
+				asset.map = new Map(asset.path);
+				break;
+		}
+	}
+	catch (std::exception& e)
+	{
+		asset.error = "Failed to load " + asset.path + ": " + e.what();
+	}
+	asset.finish_time = get_time();
+}
+
+void AssetCache::worker_main(int thread)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		work_condition.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (stopping)
+			return;
+
+		Asset& asset = *queue.front();
+		queue.pop_front();
+		asset.started = true;
+		lock.unlock();
+
+		load(asset, thread);
+
+		lock.lock();
+		asset.finished = true;
+		finished_condition.notify_all();
+	}
+}
+
+GLuint AssetCache::compile_shader(const std::string& path, GLenum shader_type)
+{
+	try
+	{
+		return compile_shader_from_source(get_text(path).c_str(), shader_type);
+	}
+	catch (std::runtime_error& e)
+	{
+		throw std::runtime_error(std::string("[") + path + "] " + e.what());
+	}
+}
+
+float AssetCache::get_time() const
+{
+	return std::chrono::duration<float, std::milli>(Clock::now() - creation_time).count();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#define NOMINMAX
+#include <GL/gl3w.h>
+#include <yaml-cpp/yaml.h>
+#include <gli/gli.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+#include "car2d_sim/map.hpp"
+
+enum AssetType
+{
+	ASSET_TEXT,									// A text file, e.g. shader source.
+	ASSET_YAML,									// A parsed YAML document.
+	ASSET_IMAGE,								// A decoded DDS image, uploaded as a texture on request.
+	ASSET_MAP									// A Map, compiled or parsed.
+};
+
+struct AssetRequest
+{
+	AssetType type;
+	std::string path;
+
+	AssetRequest(AssetType type, const std::string& path);
+};
+
+/*
+	Loads every file once, on worker threads, and hands out the result by path.
+
+	Requesting an asset queues it for the workers and returns at once; asking for it with one of the
+	get functions waits for it, or loads it on the calling thread if no worker has started on it yet.
+	Decoding happens on the workers, but the GL objects made from the results (textures and programs)
+	are created by the get functions, so those must be called on the thread with the GL context.
+
+	Programs are shared by everyone who asks for the same pair of shaders. A linked program is saved
+	as a binary next to its vertex shader (plain_2d.vert gives plain_2d.progbin), keyed by a hash of
+	both sources and the driver strings, and later runs load that binary instead of compiling. Any
+	change to the sources or the driver, or a binary the driver rejects, falls back to compiling.
+
+	The cache owns everything it hands out, including the GL objects, and a second request for a path
+	returns the same asset. Each asset records when it was queued, loaded and uploaded, and
+	print_timeline() shows that relative to when the cache was created.
+
+	Usage:
+
+	AssetCache assets(0, requests);
+	GLuint texture = assets.get_texture(DIRECTORY_TEXTURES + "grass.dds");
+	const YAML::Node& car_file = assets.get_yaml(DIRECTORY_CARS + "test_car.yaml");
+*/
+class AssetCache
+{
+public:
+	/* Start the workers and queue the requests. Zero threads means one per hardware thread. */
+	AssetCache(int thread_count, const std::vector<AssetRequest>& requests);
+	~AssetCache();
+
+	/* Queue a load unless the path is already known. */
+	void request(AssetType type, const std::string& path);
+
+	const std::string& get_text(const std::string& path);
+	const YAML::Node& get_yaml(const std::string& path);
+	Map& get_map(const std::string& path);
+
+	/* Create a texture from the image, the first time it is asked for. */
+	GLuint get_texture(const std::string& path);
+
+	/* Link a program from the two shaders, or load its cached binary, the first time the pair is asked for. */
+	GLuint get_program(const std::string& vs_path, const std::string& fs_path);
+
+	/* Print when each asset was queued, loaded and uploaded, in ms since the cache was created, and how each program was made. */
+	void print_timeline(std::ostream& out) const;
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Asset
+	{
+		AssetType type;
+		std::string path;
+		bool started;							// Guarded by the mutex.
+		bool finished;							// Guarded by the mutex.
+		std::string error;
+
+		std::string text;
+		YAML::Node yaml;
+		gli::storage image;
+		Map* map;
+		GLuint gl_object;						// The texture, 0 until asked for.
+
+		float queued_time;						// (ms)
+		float start_time;						// (ms)
+		float finish_time;						// (ms)
+		float upload_time;						// The time spent creating the GL object (ms)
+		int loaded_by;							// 0 for the thread that created the cache, the worker number otherwise.
+	};
+
+	struct Program
+	{
+		std::string name;						// The path of the binary.
+		GLuint program;
+		bool from_binary;
+		float link_time;						// The time spent compiling and linking, or loading the binary (ms)
+	};
+
+	Clock::time_point creation_time;
+	std::map<std::string, Asset*> assets;		// Only touched by the thread that created the cache.
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable work_condition;
+	std::condition_variable finished_condition;
+	std::deque<Asset*> queue;
+	bool stopping;
+	std::map<std::string, Program> programs;	// By the path of the binary.
+	std::string driver;							// The GL vendor, renderer and version, read on the first get_program().
+
+	AssetCache(const AssetCache&);
+	AssetCache& operator=(const AssetCache&);
+
+	Asset& wait(AssetType type, const std::string& path);
+	void load(Asset& asset, int thread);
+	void worker_main(int thread);
+	float get_time() const;
+	GLuint compile_shader(const std::string& path, GLenum shader_type);
+};
\ No newline at end of file
@@ -83,3 +83,20 @@ glm::mat3 Camera::create_projection(float scale, float viewport_width, float vie
 					 0,				 scale,	0,
 					 0,				 0,		1);
 }
+
+void Camera::get_view_bounds(glm::vec2& bounds_min, glm::vec2& bounds_max) const
+{
+	// Take the corners of normalized device space back to the world. They are not axis aligned
+	// when the camera is rotated, so bound all four.
+	glm::mat3 inverse = glm::inverse(projection * view);
+	glm::vec2 corners[] = { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, 1.0f) };
+
+	bounds_min = glm::vec2(inverse * glm::vec3(corners[0], 1.0f));
+	bounds_max = bounds_min;
+	for (int i = 1; i < 4; ++i)
+	{
+		glm::vec2 corner = glm::vec2(inverse * glm::vec3(corners[i], 1.0f));
+		bounds_min = glm::min(bounds_min, corner);
+		bounds_max = glm::max(bounds_max, corner);
+	}
+}
\ No newline at end of file
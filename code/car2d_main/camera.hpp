@@ -17,6 +17,9 @@ public:
 	const glm::mat3& get_view() const;
 	const glm::mat3& get_projection() const;
 
+	/* Get the axis aligned world space rectangle that contains everything the camera sees. */
+	void get_view_bounds(glm::vec2& bounds_min, glm::vec2& bounds_max) const;
+
 	static glm::mat3 create_projection(float scale, float viewport_width, float viewport_height);
 private:
 	glm::vec2 facing;
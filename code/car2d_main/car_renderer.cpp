@@ -0,0 +1,97 @@
+#include "car_renderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+const int CarRenderer::INSTANCES_PER_CAR = 5;
+
+CarRenderer::CarRenderer(AssetCache& assets)
+	: instance_buffer(0)
+	, instance_capacity(0)
+{
+	glm::vec2 positions[] = { glm::vec2(-0.5f, -0.5f), glm::vec2(-0.5f, 0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(0.5f, 0.5f) };
+
+	glGenVertexArrays(1, &quad_vao);
+	glBindVertexArray(quad_vao);
+
+	glGenBuffers(1, &quad_position_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, quad_position_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * 4, positions, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	glEnableVertexAttribArray(0);
+
+	// The instance buffer is given its storage on the first render().
+	glGenBuffers(1, &instance_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CarInstance), (const GLvoid*) offsetof(CarInstance, axis_x));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CarInstance), (const GLvoid*) offsetof(CarInstance, axis_y));
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(CarInstance), (const GLvoid*) offsetof(CarInstance, translation));
+	for (int i = 1; i <= 3; ++i)
+	{
+		glVertexAttribDivisor(i, 1);
+		glEnableVertexAttribArray(i);
+	}
+
+	mesh_program = assets.get_program(DIRECTORY_SHADERS + FILE_PLAIN2D_VS, DIRECTORY_SHADERS + FILE_PLAIN2D_FS);
+}
+
+CarRenderer::~CarRenderer()
+{
+	glDeleteVertexArrays(1, &quad_vao);
+	glDeleteBuffers(1, &quad_position_vbo);
+	glDeleteBuffers(1, &instance_buffer);
+}
+
+void CarRenderer::add(const CarDescription& description, const CarPose& pose)
+{
+	// The unit quad is scaled, then rotated, then moved into place. For the wheels it is first moved
+	// to the axle and turned by the steering angle in car space.
+	glm::vec2 forward(std::cos(pose.orientation), std::sin(pose.orientation));
+	glm::vec2 left(-forward.y, forward.x);
+
+	CarInstance chassis;
+	chassis.axis_x = forward * (description.cg_to_back + description.cg_to_front);
+	chassis.axis_y = left * (2.0f * description.halfwidth);
+	chassis.translation = pose.position;
+	instances.push_back(chassis);
+
+	float wheel_length = 2.0f * description.wheel_radius;
+	glm::vec2 steer_forward(std::cos(pose.orientation + pose.steer_angle), std::sin(pose.orientation + pose.steer_angle));
+	glm::vec2 steer_left(-steer_forward.y, steer_forward.x);
+	glm::vec2 offsets[] = { glm::vec2(description.cg_to_front_axle, description.halfwidth),
+							glm::vec2(description.cg_to_front_axle, -description.halfwidth),
+							glm::vec2(-description.cg_to_back_axle, description.halfwidth),
+							glm::vec2(-description.cg_to_back_axle, -description.halfwidth) };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		// Only the front wheels steer.
+		bool front = i < 2;
+
+		CarInstance wheel;
+		wheel.axis_x = (front ? steer_forward : forward) * wheel_length;
+		wheel.axis_y = (front ? steer_left : left) * description.wheel_width;
+		wheel.translation = pose.position + forward * offsets[i].x + left * offsets[i].y;
+		instances.push_back(wheel);
+	}
+}
+
+void CarRenderer::render()
+{
+	if (instances.empty())
+		return;
+
+	// Orphan the storage the last frame drew from rather than wait for it, growing it if it is too small.
+	int instance_count = static_cast<int>(instances.size());
+	instance_capacity = std::max(instance_capacity, instance_count);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(CarInstance) * instance_capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(CarInstance) * instance_count, &instances[0]);
+
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glUseProgram(mesh_program);
+	glBindVertexArray(quad_vao);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instance_count);
+
+	instances.clear();
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#define NOMINMAX
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "car2d_sim/car.hpp"
+#include "config.hpp"
+#include "asset_cache.hpp"
+#include "render_snapshot.hpp"
+
+/* The transform of one quad, the chassis or a wheel, as the columns of a 2D affine matrix. */
+struct CarInstance
+{
+	glm::vec2 axis_x;
+	glm::vec2 axis_y;
+	glm::vec2 translation;
+};
+
+/*
+	Draws cars as a wireframe chassis with four wheels.
+
+	Cars are added during the frame and drawn by render(). The transforms of every chassis and wheel go
+	into one instance buffer, and everything is a single instanced draw of a unit quad, so the number
+	of draw calls stays the same however many cars there are.
+
+	Usage:
+
+	car_renderer.add(car.get_description(), pose);
+	car_renderer.render();
+*/
+class CarRenderer
+{
+public:
+	/* The quads per car: the chassis and four wheels. */
+	static const int INSTANCES_PER_CAR;
+
+	CarRenderer(AssetCache& assets);
+	~CarRenderer();
+
+	void add(const CarDescription& description, const CarPose& pose);
+
+	/* Draw the cars added since the last render(). */
+	void render();
+private:
+	std::vector<CarInstance> instances;			// Kept between frames so it keeps its capacity.
+	GLuint mesh_program;
+	GLuint quad_position_vbo;
+	GLuint quad_vao;
+	GLuint instance_buffer;
+	int instance_capacity;						// The size of the instance buffer, in instances.
+
+	CarRenderer(const CarRenderer&);
+	CarRenderer& operator=(const CarRenderer&);
+};
\ No newline at end of file
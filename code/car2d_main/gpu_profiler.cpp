@@ -0,0 +1,89 @@
+#include "gpu_profiler.hpp"
+
+GpuProfiler::GpuProfiler(Profiler& profiler)
+	: profiler(profiler)
+	, track(profiler.add_track("GPU"))
+	, frame(0)
+	, open_scopes(0)
+{
+	for (int i = 0; i < FRAME_LATENCY; ++i)
+	{
+		glGenQueries(MAX_QUERIES, frames[i].queries);
+		frames[i].query_count = 0;
+		frames[i].clock_offset = 0;
+	}
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	for (int i = 0; i < FRAME_LATENCY; ++i)
+	{
+		glDeleteQueries(MAX_QUERIES, frames[i].queries);
+	}
+}
+
+void GpuProfiler::begin_frame()
+{
+	frame = (frame + 1) % FRAME_LATENCY;
+	resolve(frames[frame]);
+
+	// Both clocks are read back to back, the difference is good to well under a microsecond.
+	GLint64 gpu_time;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+	frames[frame].clock_offset = profile_now() - gpu_time;
+
+	open_scopes = 0;
+	begin("frame");
+}
+
+void GpuProfiler::end_frame()
+{
+	while (open_scopes > 0)
+	{
+		end();
+	}
+}
+
+bool GpuProfiler::begin(const char* name)
+{
+	// Keep room for the end of this scope and of every scope still open.
+	Frame& current = frames[frame];
+	if (current.query_count + open_scopes + 2 > MAX_QUERIES)
+		return false;
+
+	glQueryCounter(current.queries[current.query_count], GL_TIMESTAMP);
+	current.names[current.query_count] = name;
+	current.query_count++;
+	open_scopes++;
+	return true;
+}
+
+void GpuProfiler::end()
+{
+	Frame& current = frames[frame];
+	glQueryCounter(current.queries[current.query_count], GL_TIMESTAMP);
+	current.names[current.query_count] = nullptr;
+	current.query_count++;
+	open_scopes--;
+}
+
+void GpuProfiler::resolve(Frame& resolved)
+{
+	if (resolved.query_count == 0)
+		return;
+
+	// The queries finish in order, so the last one being ready means they all are.
+	GLint available = 0;
+	glGetQueryObjectiv(resolved.queries[resolved.query_count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available)
+	{
+		for (int i = 0; i < resolved.query_count; ++i)
+		{
+			GLint64 gpu_time;
+			glGetQueryObjecti64v(resolved.queries[i], GL_QUERY_RESULT, &gpu_time);
+			profiler.add_event(track, resolved.names[i], gpu_time + resolved.clock_offset);
+		}
+	}
+
+	resolved.query_count = 0;
+}
\ No newline at end of file
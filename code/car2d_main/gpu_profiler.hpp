@@ -0,0 +1,90 @@
+#pragma once
+
+#define NOMINMAX
+#include <GL/gl3w.h>
+#include "car2d_sim/profiler.hpp"
+
+/*
+	Times passes on the GPU with timestamp queries and adds them to a "GPU" track of the profiler, next
+	to the CPU scopes. Like those it only exists when CAR2D_PROFILE is defined.
+
+	The queries of a frame are read FRAME_LATENCY frames later, when the GPU is long done with them, so
+	reading them never stalls; a frame whose queries are still not ready by then is left out. GPU
+	timestamps are moved onto the CPU clock with an offset measured at the start of every frame.
+
+	Usage:
+
+	GpuProfiler gpu_profiler(profiler);
+	each frame:
+		gpu_profiler.begin_frame();
+		{
+			PROFILE_GPU_SCOPE(gpu_profiler, "terrain");
+			terrain.render(uniforms);
+		}
+		gpu_profiler.end_frame();
+*/
+#ifdef CAR2D_PROFILE
+#define PROFILE_GPU_SCOPE(gpu_profiler, name) PROFILE_SCOPE(name); GpuProfileScope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(gpu_profiler, name)
+#else
+#define PROFILE_GPU_SCOPE(gpu_profiler, name) ((void) 0)
+#endif
+
+class GpuProfiler
+{
+public:
+	static const int FRAME_LATENCY = 4;
+	static const int MAX_QUERIES = 64;			// Per frame, two per scope.
+
+	GpuProfiler(Profiler& profiler);
+	~GpuProfiler();
+
+	/* Read the queries of the oldest frame and open the "frame" scope of this one. */
+	void begin_frame();
+	void end_frame();
+
+	/* Returns false if the scope was not recorded, in which case end() must not be called. */
+	bool begin(const char* name);
+	void end();
+private:
+	struct Frame
+	{
+		GLuint queries[MAX_QUERIES];
+		const char* names[MAX_QUERIES];			// nullptr for the end of a scope.
+		int query_count;
+		long long clock_offset;					// Added to the GPU time to get the CPU time (ns)
+	};
+
+	Profiler& profiler;
+	int track;
+	Frame frames[FRAME_LATENCY];
+	int frame;
+	int open_scopes;
+
+	GpuProfiler(const GpuProfiler&);
+	GpuProfiler& operator=(const GpuProfiler&);
+
+	void resolve(Frame& resolved);
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler& gpu_profiler, const char* name)
+		: gpu_profiler(gpu_profiler)
+		, recorded(gpu_profiler.begin(name))
+	{
+
+	}
+
+	~GpuProfileScope()
+	{
+		if (recorded)
+			gpu_profiler.end();
+	}
+private:
+	GpuProfiler& gpu_profiler;
+	bool recorded;
+
+	GpuProfileScope(const GpuProfileScope&);
+	GpuProfileScope& operator=(const GpuProfileScope&);
+};
\ No newline at end of file
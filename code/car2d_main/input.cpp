@@ -54,6 +54,23 @@ Controls::Controls(const YAML::Node& config)
 	mapping["LEFT"] = SDL_SCANCODE_LEFT;
 	mapping["RIGHT"] = SDL_SCANCODE_RIGHT;
 	mapping["SPACE"] = SDL_SCANCODE_SPACE;
+	mapping["TAB"] = SDL_SCANCODE_TAB;
+	mapping["PAGEUP"] = SDL_SCANCODE_PAGEUP;
+	mapping["PAGEDOWN"] = SDL_SCANCODE_PAGEDOWN;
+	mapping["HOME"] = SDL_SCANCODE_HOME;
+	mapping["END"] = SDL_SCANCODE_END;
+	mapping["F1"] = SDL_SCANCODE_F1;
+	mapping["F2"] = SDL_SCANCODE_F2;
+	mapping["F3"] = SDL_SCANCODE_F3;
+	mapping["F4"] = SDL_SCANCODE_F4;
+	mapping["F5"] = SDL_SCANCODE_F5;
+	mapping["F6"] = SDL_SCANCODE_F6;
+	mapping["F7"] = SDL_SCANCODE_F7;
+	mapping["F8"] = SDL_SCANCODE_F8;
+	mapping["F9"] = SDL_SCANCODE_F9;
+	mapping["F10"] = SDL_SCANCODE_F10;
+	mapping["F11"] = SDL_SCANCODE_F11;
+	mapping["F12"] = SDL_SCANCODE_F12;
 
 	load_controls(accelerate, config["Controls"]["Accelerate"], mapping);
 	load_controls(reverse, config["Controls"]["Reverse"], mapping);
@@ -63,6 +80,12 @@ Controls::Controls(const YAML::Node& config)
 	load_controls(gear_up, config["Controls"]["GearUp"], mapping);
 	load_controls(gear_down, config["Controls"]["GearDown"], mapping);
 	load_controls(toggle_automatic, config["Controls"]["ToggleAutomatic"], mapping);
+	load_controls(toggle_stats, config["Controls"]["ToggleStats"], mapping);
+	load_controls(save_profile, config["Controls"]["SaveProfile"], mapping);
+	load_controls(slow_down, config["Controls"]["SlowDown"], mapping);
+	load_controls(speed_up, config["Controls"]["SpeedUp"], mapping);
+	load_controls(real_time, config["Controls"]["RealTime"], mapping);
+	load_controls(uncapped, config["Controls"]["Uncapped"], mapping);
 }
 
 bool Controls::is_pressed(const std::vector<SDL_Scancode>& scancodes, const InputState& input_state_current) const
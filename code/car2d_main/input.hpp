@@ -23,6 +23,12 @@ public:
 	std::vector<SDL_Scancode> gear_up;
 	std::vector<SDL_Scancode> gear_down;
 	std::vector<SDL_Scancode> toggle_automatic;
+	std::vector<SDL_Scancode> toggle_stats;
+	std::vector<SDL_Scancode> save_profile;
+	std::vector<SDL_Scancode> slow_down;
+	std::vector<SDL_Scancode> speed_up;
+	std::vector<SDL_Scancode> real_time;
+	std::vector<SDL_Scancode> uncapped;
 
 	Controls(const YAML::Node& config);
 
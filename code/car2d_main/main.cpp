@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <chrono>
+#include <thread>
 #define NOMINMAX
 #include <GL/gl3w.h>
 #include "debug.hpp"
@@ -31,7 +33,7 @@ int main(int argc, char* argv[])
 	return result;
 }
 
-void __stdcall output_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* param)
+void APIENTRY output_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* param)
 {
 	if (type == GL_DEBUG_TYPE_ERROR)
 	{
@@ -104,8 +106,7 @@ WindowContext::WindowContext(const YAML::Node& config, int viewport_width, int v
 		std::cout << "OpenGL version: " << major << "." << minor << std::endl;
 	}
 
-	// Set V-Sync enabled.
-	SDL_GL_SetSwapInterval(1);
+	SDL_GL_SetSwapInterval(config["Window"]["VSync"].as<bool>() ? 1 : 0);
 }
 
 WindowContext::~WindowContext()
@@ -123,14 +124,70 @@ Car2DMain::Car2DMain()
 	, viewport_height(config["Window"]["Height"].as<int>())
 	, running(true)
 	, window_context(config, viewport_width, viewport_height)
-	, ticker(DT, 5)
-	, stats(viewport_width, viewport_height)
+	, assets(config["Assets"]["LoaderThreads"].as<int>(), get_startup_assets(config))
+	, uniforms(UNIFORM_RING_FRAME_SIZE, UNIFORM_RING_FRAMES)
+#ifdef CAR2D_PROFILE
+	, gpu_profiler(profiler)
+#endif
+	, controls(config)
+	, ticker(1.0f / config["Simulation"]["TickRate"].as<float>(), 5)
+	, stats(assets, viewport_width, viewport_height)
 	, camera(Camera::create_projection(2.0f / zoom_level, viewport_width, viewport_height))
-	, car(YAML::LoadFile(DIRECTORY_CARS + config["Assets"]["DefaultCar"].as<std::string>()), config, stats)
-	, terrain(YAML::LoadFile(DIRECTORY_MAPS + config["Assets"]["DefaultMap"].as<std::string>()))
-	, road(YAML::LoadFile(DIRECTORY_MAPS + config["Assets"]["DefaultMap"].as<std::string>()))
+	, job_pool(config["Simulation"]["WorkerThreads"].as<int>())
+	, car(assets.get_yaml(DIRECTORY_CARS + config["Assets"]["DefaultCar"].as<std::string>()), config)
+	, fleet(car.get_description())
+	, car_renderer(assets)
+	, map(load_map(DIRECTORY_MAPS + config["Assets"]["DefaultMap"].as<std::string>()))
+	, road_streamer(map, DIRECTORY_MAPS, config["Road"]["TileBudget"].as<int>(), config["Road"]["PreloadDistance"].as<float>())
+	, road_renderer(road_streamer, assets, map.get_properties())
+	, terrain(assets, map.get_properties())
+	, simulation(car, fleet, job_pool, telemetry, 1.0f / config["Simulation"]["TickRate"].as<float>())
+	, time_scales(config["Simulation"]["TimeScales"].as<std::vector<float> >())
+	, real_time_index(static_cast<int>(std::find(time_scales.begin(), time_scales.end(), 1.0f) - time_scales.begin()))
+	, time_scale_index(real_time_index)
+	, uncapped(false)
+	, fast_forward_frame_period(std::chrono::duration_cast<Simulation::Clock::duration>(std::chrono::duration<float>(1.0f / config["Simulation"]["FastForwardFrameRate"].as<float>())))
 {
+	if (real_time_index == time_scales.size())
+		throw std::runtime_error("Simulation: TimeScales must include 1.0");
+
 	setup_resources();
+	spawn_fleet(config["Simulation"]["FleetSize"].as<int>());
+	if (!config["Recording"]["Path"].as<std::string>().empty())
+	{
+		std::string format = config["Recording"]["Format"].as<std::string>();
+		if (format != "Columns" && format != "CSV")
+			throw std::runtime_error("Unknown recording format " + format + ", expected Columns or CSV");
+		simulation.record(config["Recording"]["Path"].as<std::string>(), format == "CSV" ? STAT_FORMAT_CSV : STAT_FORMAT_COLUMNS);
+	}
+	simulation.start();
+	assets.print_timeline(std::cout);
+}
+
+std::vector<AssetRequest> Car2DMain::get_startup_assets(const YAML::Node& config)
+{
+	// Everything the constructor is going to ask for, so it all loads at once.
+	std::vector<AssetRequest> requests;
+	requests.push_back(AssetRequest(ASSET_MAP, DIRECTORY_MAPS + config["Assets"]["DefaultMap"].as<std::string>()));
+	requests.push_back(AssetRequest(ASSET_YAML, DIRECTORY_CARS + config["Assets"]["DefaultCar"].as<std::string>()));
+
+	const std::string shaders[] = { FILE_PLAIN2D_VS, FILE_PLAIN2D_FS, FILE_MESH2D_VS, FILE_MESH2D_FS, FILE_TERRAIN_VS, FILE_TERRAIN_FS, FILE_TEXT_VS, FILE_TEXT_FS };
+	for (int i = 0; i < sizeof(shaders) / sizeof(shaders[0]); ++i)
+	{
+		requests.push_back(AssetRequest(ASSET_TEXT, DIRECTORY_SHADERS + shaders[i]));
+	}
+
+	return requests;
+}
+
+Map& Car2DMain::load_map(const std::string& path)
+{
+	Map& loaded_map = assets.get_map(path);
+
+	// The textures are named in the map, queue them before anything waits for them.
+	assets.request(ASSET_IMAGE, DIRECTORY_TEXTURES + loaded_map.get_properties()["GroundTexture"].as<std::string>());
+	assets.request(ASSET_IMAGE, DIRECTORY_TEXTURES + loaded_map.get_properties()["RoadTexture"].as<std::string>());
+	return loaded_map;
 }
 
 Car2DMain::~Car2DMain()
@@ -144,33 +201,62 @@ void Car2DMain::setup_resources()
 	camera.set_facing(glm::vec2(0.0f, 1.0f));
 	camera.recalculate_matrices();
 
-	uniform_frame_data.view_matrix = glm::mat3x4(camera.get_view());
-	uniform_frame_data.projection_matrix = glm::mat3x4(camera.get_projection());
-	glGenBuffers(1, &uniform_frame_buffer);
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_FRAME_BINDING, uniform_frame_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrame), &uniform_frame_data, GL_DYNAMIC_DRAW);
+	if (map.is_compiled())
+		std::cout << "Loaded the compiled map" << std::endl;
+
+	telemetry_frame_time = telemetry.register_channel("frame time", TELEMETRY_FLOAT, "Frame time: %.1f ms");
+	telemetry_render_time = telemetry.register_channel("render time", TELEMETRY_FLOAT, "Render submission: %.3f ms");
+	telemetry_road_segments = telemetry.register_channel("road segments", TELEMETRY_INT, "Road segments drawn: %d");
+	telemetry_road_tiles = telemetry.register_channel("road tiles", TELEMETRY_INT2, "Road tiles: %d resident, %d loading");
+	telemetry.register_channel("blank0", TELEMETRY_NONE, "");
+	car.set_telemetry(&telemetry);
+}
+
+void Car2DMain::spawn_fleet(int fleet_size)
+{
+	// Line the cars up in rows of ten behind the player.
+	const int ROW_LENGTH = 10;
+	const float SPACING_X = 3.0f;
+	const float SPACING_Y = 6.0f;
+
+	for (int i = 0; i < fleet_size; ++i)
+	{
+		glm::vec2 position((i % ROW_LENGTH - 0.5f * (ROW_LENGTH - 1)) * SPACING_X, -SPACING_Y * (1 + i / ROW_LENGTH));
+		fleet.add_car(position, 90.0f * DEGREES_TO_RADIANS);
+	}
+
+	if (fleet_size > 0)
+		std::cout << "Spawned a fleet of " << fleet_size << " cars stepped by " << job_pool.get_thread_count() << " threads" << std::endl;
 }
 
 void Car2DMain::start()
 {
+	PROFILE_THREAD("main");
 	ticker.start();
 	while (running)
 	{
 		ticker.tick();
-		
+#ifdef CAR2D_PROFILE
+		profiler.collect();
+#endif
+
+		Simulation::Clock::time_point frame_start = Simulation::Clock::now();
 		handle_events();
-		while (ticker.poll_fixed_tick())
-		{
-			update(DT);
-		}
+		render();
 
-		render(DT, ticker.get_interpolation());
+		// Fast forward draws only now and then, leaving the cores to the simulation and the fleet.
+		if (is_fast_forward())
+			std::this_thread::sleep_until(frame_start + fast_forward_frame_period);
 	}
 }
 
 void Car2DMain::handle_events()
 {
-	input_state_previous = input_state_current;
+	PROFILE_SCOPE("events");
+
+	// SDL stamps events in milliseconds since it started, find when that was on the simulation clock.
+	Uint32 sdl_now = SDL_GetTicks();
+	Simulation::Clock::time_point now = Simulation::Clock::now();
 
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
@@ -199,13 +285,15 @@ void Car2DMain::handle_events()
 			} break;
 
 			case SDL_KEYDOWN:
-			{
-				input_state_current.keys[event.key.keysym.scancode] = true;
-			} break;
-
 			case SDL_KEYUP:
 			{
-				input_state_current.keys[event.key.keysym.scancode] = false;
+				if (event.key.repeat != 0)
+					break;
+
+				input_state_current.keys[event.key.keysym.scancode] = event.type == SDL_KEYDOWN;
+
+				Uint32 age = event.key.timestamp < sdl_now ? sdl_now - event.key.timestamp : 0;
+				handle_key_change(now - std::chrono::milliseconds(age));
 			} break;
 
 			case SDL_MOUSEWHEEL:
@@ -221,29 +309,60 @@ void Car2DMain::handle_events()
 		}
 	}
 
-	car.handle_input(input_state_current, input_state_previous);
-}
-
-void Car2DMain::update(float dt)
-{
 	if (input_state_current.keys[SDL_SCANCODE_ESCAPE])
 		running = false;
+}
 
-	// Update the car.
-	car.update(dt);
+void Car2DMain::handle_key_change(Simulation::Clock::time_point time)
+{
+	// Every key change is sent on its own, so the simulation can apply it at the tick it happened in.
+	CarInput car_input;
+	car_input.throttle = controls.is_pressed(controls.accelerate, input_state_current);
+	car_input.reverse = controls.is_pressed(controls.reverse, input_state_current);
+	car_input.ebrake = controls.is_pressed(controls.ebrake, input_state_current);
+	car_input.steer = (float) ((int) controls.is_pressed(controls.left, input_state_current) - (int) controls.is_pressed(controls.right, input_state_current));
+	car_input.gear_up = controls.is_clicked(controls.gear_up, input_state_current, input_state_previous);
+	car_input.gear_down = controls.is_clicked(controls.gear_down, input_state_current, input_state_previous);
+	car_input.toggle_automatic = controls.is_clicked(controls.toggle_automatic, input_state_current, input_state_previous);
+	simulation.send_input(car_input, time);
+
+	if (controls.is_clicked(controls.slow_down, input_state_current, input_state_previous))
+		set_time_scale(uncapped ? time_scale_index : std::max(time_scale_index - 1, 0), false);
+	if (controls.is_clicked(controls.speed_up, input_state_current, input_state_previous))
+		set_time_scale(std::min(time_scale_index + 1, static_cast<int>(time_scales.size()) - 1), uncapped);
+	if (controls.is_clicked(controls.real_time, input_state_current, input_state_previous))
+		set_time_scale(real_time_index, false);
+	if (controls.is_clicked(controls.uncapped, input_state_current, input_state_previous))
+		set_time_scale(time_scale_index, true);
+
+	if (controls.is_clicked(controls.toggle_stats, input_state_current, input_state_previous))
+		stats.toggle_visible();
+#ifdef CAR2D_PROFILE
+	if (controls.is_clicked(controls.save_profile, input_state_current, input_state_previous))
+	{
+		profiler.write_chrome_trace(FILE_PROFILE_TRACE);
+		std::cout << "Wrote the profile to " << FILE_PROFILE_TRACE << std::endl;
+	}
+#endif
 
-	// Update the per frame buffer.
-	//update_camera_free(dt);
-	update_camera_chase();
-	camera.recalculate_matrices();
+	input_state_previous = input_state_current;
+}
 
-	uniform_frame_data.view_matrix = glm::mat3x4(camera.get_view());
-	uniform_frame_data.projection_matrix = glm::mat3x4(camera.get_projection());
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_FRAME_BINDING, uniform_frame_buffer);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PerFrame), &uniform_frame_data);
+void Car2DMain::set_time_scale(int index, bool uncapped)
+{
+	time_scale_index = index;
+	this->uncapped = uncapped;
+	simulation.set_time_scale(uncapped ? Simulation::UNCAPPED : time_scales[index]);
+
+	if (uncapped)
+		std::cout << "Time scale: uncapped" << std::endl;
+	else
+		std::cout << "Time scale: " << time_scales[index] << "x" << std::endl;
+}
 
-	// Update the statistics.	
-	stats.update_text();
+bool Car2DMain::is_fast_forward() const
+{
+	return uncapped || time_scales[time_scale_index] > 1.0f;
 }
 
 void Car2DMain::update_camera_free(float dt)
@@ -276,21 +395,91 @@ void Car2DMain::update_camera_free(float dt)
 	camera.set_facing(facing);
 }
 
-void Car2DMain::update_camera_chase()
+void Car2DMain::update_camera_chase(const glm::vec2& target)
 {
-	camera.set_origin(car.get_position());
+	camera.set_origin(target);
 }
 
-void Car2DMain::render(float dt, float interpolation)
+void Car2DMain::render()
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	PROFILE_SCOPE("render");
+	Simulation::Clock::time_point render_start = Simulation::Clock::now();
+#ifdef CAR2D_PROFILE
+	gpu_profiler.begin_frame();
+#endif
+
+	// Draw one tick behind the newest state, blending the last two ticks by the time since it was due.
+	// Uncapped ticks have no period, the newest is drawn as is.
+	const SimulationFrame& frame = simulation.get_frame();
+	float interpolation = 1.0f;
+	if (frame.tick_period.count() > 0)
+		interpolation = glm::clamp(std::chrono::duration<float>(render_start - frame.tick_time).count() / std::chrono::duration<float>(frame.tick_period).count(), 0.0f, 1.0f);
+	CarPose car_pose = interpolate(frame.previous.car, frame.current.car, interpolation);
+	telemetry.copy_values(frame.telemetry);
 
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_FRAME_BINDING, uniform_frame_buffer);
+	{
+		PROFILE_GPU_SCOPE(gpu_profiler, "clear");
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
 
-	terrain.render();
-	road.render();
-	car.render(dt, interpolation);
-	stats.render();
+	// Update the camera.
+	//update_camera_free(ticker.get_frame_time());
+	update_camera_chase(car_pose.position);
+	camera.recalculate_matrices();
+
+	uniform_frame_data.view_matrix = glm::mat3x4(camera.get_view());
+	uniform_frame_data.projection_matrix = glm::mat3x4(camera.get_projection());
+
+	uniforms.begin_frame();
+	uniforms.bind(UNIFORM_FRAME_BINDING, uniform_frame_data);
+
+	// Stream the road around what the camera sees.
+	glm::vec2 view_min;
+	glm::vec2 view_max;
+	camera.get_view_bounds(view_min, view_max);
+	{
+		PROFILE_SCOPE("road streaming");
+		road_streamer.update(view_min, view_max);
+		road_renderer.update();
+	}
+
+	{
+		PROFILE_GPU_SCOPE(gpu_profiler, "terrain");
+		terrain.render(uniforms);
+	}
+	{
+		PROFILE_GPU_SCOPE(gpu_profiler, "road");
+		road_renderer.render(camera, uniforms);
+	}
+	{
+		PROFILE_GPU_SCOPE(gpu_profiler, "cars");
+		car_renderer.add(car.get_description(), car_pose);
+		for (int i = 0; i < frame.current.fleet.size(); ++i)
+		{
+			car_renderer.add(fleet.get_description(), interpolate(frame.previous.fleet[i], frame.current.fleet[i], interpolation));
+		}
+		car_renderer.render();
+	}
+
+	// Publish the frame statistics and format the telemetry once per frame.
+	telemetry.set(telemetry_frame_time, ticker.get_frame_time() * 1000.0f);
+	telemetry.set(telemetry_render_time, std::chrono::duration<float, std::milli>(Simulation::Clock::now() - render_start).count());
+	telemetry.set(telemetry_road_segments, road_renderer.get_drawn_segment_count());
+	telemetry.set(telemetry_road_tiles, road_streamer.get_resident_tile_count(), road_streamer.get_loading_tile_count());
+#ifdef CAR2D_PROFILE
+	stats.update_text(telemetry, profiler);
+#else
+	stats.update_text(telemetry);
+#endif
+	{
+		PROFILE_GPU_SCOPE(gpu_profiler, "stats");
+		stats.render(uniforms);
+	}
+	uniforms.end_frame();
+#ifdef CAR2D_PROFILE
+	gpu_profiler.end_frame();
+#endif
 
+	PROFILE_SCOPE("swap");
 	SDL_GL_SwapWindow(window_context.window);
 }
\ No newline at end of file
@@ -3,13 +3,23 @@
 #include <SDL2/SDL.h>
 #include <yaml-cpp/yaml.h>
 #include "config.hpp"
-#include "ticker.hpp"
+#include "car2d_sim/ticker.hpp"
+#include "car2d_sim/car.hpp"
+#include "car2d_sim/car_batch.hpp"
+#include "car2d_sim/job_pool.hpp"
+#include "car2d_sim/map.hpp"
+#include "car2d_sim/road_streamer.hpp"
+#include "car2d_sim/telemetry.hpp"
 #include "input.hpp"
 #include "camera.hpp"
-#include "car.hpp"
-#include "road.hpp"
+#include "car_renderer.hpp"
+#include "road_renderer.hpp"
 #include "terrain.hpp"
 #include "stats.hpp"
+#include "asset_cache.hpp"
+#include "uniform_ring.hpp"
+#include "simulation.hpp"
+#include "gpu_profiler.hpp"
 
 class WindowContext
 {
@@ -37,21 +47,48 @@ private:
 	int viewport_height;
 	bool running;
 	WindowContext window_context;
+	AssetCache assets;
+	UniformRing uniforms;
+#ifdef CAR2D_PROFILE
+	Profiler profiler;
+	GpuProfiler gpu_profiler;
+#endif
 	InputState input_state_current;
 	InputState input_state_previous;
+	Controls controls;
 	Ticker ticker;
 	Camera camera;
+	JobPool job_pool;
+	Telemetry telemetry;
 	Car car;
-	Road road;
+	CarBatch fleet;
+	CarRenderer car_renderer;
+	Map& map;
+	RoadStreamer road_streamer;
+	RoadRenderer road_renderer;
 	Terrain terrain;
 	Stats stats;
+	Simulation simulation;
+	std::vector<float> time_scales;
+	int real_time_index;						// The index of 1.0 in time_scales.
+	int time_scale_index;
+	bool uncapped;
+	Simulation::Clock::duration fast_forward_frame_period;
 	PerFrame uniform_frame_data;
-	GLuint uniform_frame_buffer;
+	int telemetry_frame_time;
+	int telemetry_render_time;
+	int telemetry_road_segments;
+	int telemetry_road_tiles;
 
+	static std::vector<AssetRequest> get_startup_assets(const YAML::Node& config);
+	Map& load_map(const std::string& path);
 	void setup_resources();
+	void spawn_fleet(int fleet_size);
 	void handle_events();
-	void update(float dt);
+	void handle_key_change(Simulation::Clock::time_point time);
+	void set_time_scale(int index, bool uncapped);
+	bool is_fast_forward() const;
 	void update_camera_free(float dt);
-	void update_camera_chase();
-	void render(float dt, float interpolation);
+	void update_camera_chase(const glm::vec2& target);
+	void render();
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "render_snapshot.hpp"
+#include "car2d_sim/sim_config.hpp"
+#include <cmath>
+
+CarPose interpolate(const CarPose& previous, const CarPose& current, float interpolation)
+{
+	// The orientations are not wrapped, but take the short way in case they ever are.
+	float turn = current.orientation - previous.orientation;
+	turn -= 2.0f * PI * std::floor((turn + PI) / (2.0f * PI));
+
+	CarPose pose;
+	pose.position = glm::mix(previous.position, current.position, interpolation);
+	pose.orientation = previous.orientation + turn * interpolation;
+	pose.steer_angle = glm::mix(previous.steer_angle, current.steer_angle, interpolation);
+	return pose;
+}
+
+void RenderSnapshot::capture(const Car& player, const CarBatch& batch)
+{
+	car.position = player.get_position();
+	car.orientation = player.get_orientation();
+	car.steer_angle = player.get_steer_angle();
+
+	fleet.resize(batch.get_car_count());
+	for (int i = 0; i < batch.get_car_count(); ++i)
+	{
+		fleet[i].position = batch.get_position(i);
+		fleet[i].orientation = batch.get_orientation(i);
+		fleet[i].steer_angle = batch.get_steer_angle(i);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "car2d_sim/car.hpp"
+#include "car2d_sim/car_batch.hpp"
+
+/* Where a car is drawn. */
+struct CarPose
+{
+	glm::vec2 position;
+	float orientation;
+	float steer_angle;
+};
+
+/* Blend two poses, turning the shortest way between the orientations. */
+CarPose interpolate(const CarPose& previous, const CarPose& current, float interpolation);
+
+/*
+	The state of everything that moves on screen, taken after each fixed tick.
+
+	Frames are drawn between the last two snapshots, blended by how far the frame is into the next
+	tick, so the motion stays smooth when the display and the simulation run at different rates. The
+	fleet keeps its capacity between captures, so capturing does not allocate once the fleet is spawned.
+*/
+struct RenderSnapshot
+{
+	CarPose car;
+	std::vector<CarPose> fleet;
+
+	void capture(const Car& player, const CarBatch& batch);
+};
\ No newline at end of file
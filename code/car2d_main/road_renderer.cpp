@@ -0,0 +1,177 @@
+#include "road_renderer.hpp"
+#include <cstddef>
+
+RoadRenderer::RoadRenderer(const RoadStreamer& streamer, AssetCache& assets, const YAML::Node& map_file)
+	: streamer(streamer)
+	, indirect_buffer(0)
+	, indirect_buffer_capacity(0)
+	, drawn_segment_count(0)
+{
+	glGenBuffers(1, &indirect_buffer);
+
+	// Setup the program.
+	mesh_program = assets.get_program(DIRECTORY_SHADERS + FILE_MESH2D_VS, DIRECTORY_SHADERS + FILE_MESH2D_FS);
+
+	// Setup the uniform buffer.
+	uniform_instance_data.model_matrix = glm::mat3x4(glm::mat3(1.0f));
+
+	// Get the texture and create a sampler.
+	texture = assets.get_texture(DIRECTORY_TEXTURES + map_file["RoadTexture"].as<std::string>());
+
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+RoadRenderer::~RoadRenderer()
+{
+	for (int i = 0; i < tile_meshes.size(); ++i)
+	{
+		free_tile(tile_meshes[i]);
+	}
+	glDeleteBuffers(1, &indirect_buffer);
+
+	glDeleteSamplers(1, &sampler);
+}
+
+void RoadRenderer::update()
+{
+	const std::vector<int>& evicted_tiles = streamer.get_evicted_tiles();
+	for (int i = 0; i < evicted_tiles.size(); ++i)
+	{
+		for (int k = 0; k < tile_meshes.size(); ++k)
+		{
+			if (tile_meshes[k].tile == evicted_tiles[i])
+			{
+				free_tile(tile_meshes[k]);
+				tile_meshes[k] = tile_meshes.back();
+				tile_meshes.pop_back();
+				break;
+			}
+		}
+	}
+
+	const std::vector<int>& arrived_tiles = streamer.get_arrived_tiles();
+	for (int i = 0; i < arrived_tiles.size(); ++i)
+	{
+		upload_tile(arrived_tiles[i]);
+	}
+}
+
+void RoadRenderer::upload_tile(int tile)
+{
+	const RoadMesh& mesh = streamer.get_mesh(tile);
+
+	TileMesh tile_mesh;
+	tile_mesh.tile = tile;
+	tile_mesh.segment_ranges.assign(mesh.ranges, mesh.ranges + mesh.segment_count);
+	tile_mesh.first_command = 0;
+	tile_mesh.command_count = 0;
+
+	glGenVertexArrays(1, &tile_mesh.vao);
+	glBindVertexArray(tile_mesh.vao);
+
+	glGenBuffers(1, &tile_mesh.vertex_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tile_mesh.vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(RoadVertex) * mesh.vertex_count, mesh.vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(RoadVertex), (const GLvoid*) offsetof(RoadVertex, position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(RoadVertex), (const GLvoid*) offsetof(RoadVertex, texcoord));
+	glEnableVertexAttribArray(1);
+
+	glGenBuffers(1, &tile_mesh.index_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tile_mesh.index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.index_count, mesh.indices, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+
+	tile_meshes.push_back(tile_mesh);
+}
+
+void RoadRenderer::free_tile(TileMesh& tile_mesh)
+{
+	glDeleteVertexArrays(1, &tile_mesh.vao);
+	glDeleteBuffers(1, &tile_mesh.vertex_buffer);
+	glDeleteBuffers(1, &tile_mesh.index_buffer);
+}
+
+void RoadRenderer::render(const Camera& camera, UniformRing& uniforms)
+{
+	// Collect the segments that overlap the view, tile by tile.
+	glm::vec2 view_min;
+	glm::vec2 view_max;
+	camera.get_view_bounds(view_min, view_max);
+
+	draw_commands.clear();
+	for (int k = 0; k < tile_meshes.size(); ++k)
+	{
+		TileMesh& tile_mesh = tile_meshes[k];
+		tile_mesh.first_command = draw_commands.size();
+		tile_mesh.command_count = 0;
+
+		glm::vec2 tile_min;
+		glm::vec2 tile_max;
+		streamer.get_tile_bounds(tile_mesh.tile, tile_min, tile_max);
+		if (tile_max.x < view_min.x || tile_min.x > view_max.x || tile_max.y < view_min.y || tile_min.y > view_max.y)
+			continue;
+
+		const RoadBounds& bounds = streamer.get_road(tile_mesh.tile)->get_bounds();
+		for (int i = 0; i < tile_mesh.segment_ranges.size(); ++i)
+		{
+			if (bounds.max_x[i] < view_min.x || bounds.min_x[i] > view_max.x || bounds.max_y[i] < view_min.y || bounds.min_y[i] > view_max.y)
+				continue;
+
+			DrawElementsIndirectCommand command;
+			command.count = tile_mesh.segment_ranges[i].index_count;
+			command.instance_count = 1;
+			command.first_index = tile_mesh.segment_ranges[i].first_index;
+			command.base_vertex = tile_mesh.segment_ranges[i].base_vertex;
+			command.base_instance = 0;
+			draw_commands.push_back(command);
+		}
+		tile_mesh.command_count = draw_commands.size() - tile_mesh.first_command;
+	}
+
+	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	glUseProgram(mesh_program);
+	uniforms.bind(UNIFORM_INSTANCE_BINDING, uniform_instance_data);
+	
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_DIFFUSE_BINDING);
+	glBindSampler(TEXTURE_DIFFUSE_BINDING, sampler);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	
+	drawn_segment_count = draw_commands.size();
+	if (drawn_segment_count == 0)
+		return;
+
+	// Grow the indirect buffer in powers of two, so tiles streaming in do not reallocate it every frame.
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+	if (drawn_segment_count > indirect_buffer_capacity)
+	{
+		while (indirect_buffer_capacity < drawn_segment_count)
+		{
+			indirect_buffer_capacity = indirect_buffer_capacity == 0 ? 256 : indirect_buffer_capacity * 2;
+		}
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * indirect_buffer_capacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * drawn_segment_count, &draw_commands[0]);
+
+	for (int k = 0; k < tile_meshes.size(); ++k)
+	{
+		const TileMesh& tile_mesh = tile_meshes[k];
+		if (tile_mesh.command_count == 0)
+			continue;
+
+		glBindVertexArray(tile_mesh.vao);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const GLvoid*) (sizeof(DrawElementsIndirectCommand) * tile_mesh.first_command), tile_mesh.command_count, 0);
+	}
+}
+
+int RoadRenderer::get_drawn_segment_count() const
+{
+	return drawn_segment_count;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#define NOMINMAX
+#include <yaml-cpp/yaml.h>
+#include <glm/glm.hpp>
+#include <GL/gl3w.h>
+#include <vector>
+#include "car2d_sim/road.hpp"
+#include "car2d_sim/road_streamer.hpp"
+#include "config.hpp"
+#include "camera.hpp"
+#include "asset_cache.hpp"
+#include "uniform_ring.hpp"
+
+/*
+	Owns the meshes and textures for the resident tiles of a RoadStreamer.
+
+	Each tile gets its own interleaved vertex buffer and index buffer when it arrives, and loses them
+	when it is evicted. The range each segment occupies is kept in a table per tile. Every frame the
+	segments that overlap the view of the camera get a command in one shared indirect buffer, and
+	each tile with visible segments is drawn with a single glMultiDrawElementsIndirect. The overlap
+	test is a flat scan over the segment bounds of the resident tiles.
+*/
+class RoadRenderer
+{
+public:
+	RoadRenderer(const RoadStreamer& streamer, AssetCache& assets, const YAML::Node& map_file);
+	~RoadRenderer();
+
+	/* Upload the tiles that arrived and free the ones evicted in the last RoadStreamer::update(). */
+	void update();
+
+	void render(const Camera& camera, UniformRing& uniforms);
+
+	/* The number of segments submitted by the last render(). */
+	int get_drawn_segment_count() const;
+private:
+	/* The layout glMultiDrawElementsIndirect reads from the indirect buffer. */
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+
+	/* The GPU side of a resident tile. */
+	struct TileMesh
+	{
+		int tile;
+		std::vector<RoadSegmentRange> segment_ranges;
+		GLuint vertex_buffer;
+		GLuint index_buffer;
+		GLuint vao;
+		int first_command;						// Where the commands of this tile start in this frame.
+		int command_count;
+	};
+
+	const RoadStreamer& streamer;
+	std::vector<TileMesh> tile_meshes;
+	std::vector<DrawElementsIndirectCommand> draw_commands;	// The commands of the visible segments, rebuilt every frame.
+	GLuint indirect_buffer;
+	int indirect_buffer_capacity;				// In commands.
+	int drawn_segment_count;
+
+	PerInstance uniform_instance_data;
+	GLuint mesh_program;
+	GLuint texture;
+	GLuint sampler;
+
+	RoadRenderer(const RoadRenderer&);
+	RoadRenderer& operator=(const RoadRenderer&);
+
+	void upload_tile(int tile);
+	void free_tile(TileMesh& tile_mesh);
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <string>
 #include <stdexcept>
 #include <fstream>
+#include <sstream>
 
 GLuint compile_shader_from_file(const std::string& filepath, GLenum shaderType)
 {
@@ -13,14 +14,9 @@ GLuint compile_shader_from_file(const std::string& filepath, GLenum shaderType)
 		throw std::runtime_error(std::string("Failed to open shader file: ") + filepath);
 	}
 
-	std::string source;
-	while (!file.eof())
-	{
-		std::string line;
-		std::getline(file, line);
-
-		source += line + "\n";
-	}
+	std::ostringstream source_stream;
+	source_stream << file.rdbuf();
+	std::string source = source_stream.str();
 
 	try
 	{
@@ -84,4 +80,35 @@ GLuint link_program(GLuint program)
 	}
 
 	return program;
+}
+
+GLuint load_program_binary(GLenum format, const void* binary, GLsizei size)
+{
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, binary, size);
+
+	// Drivers reject binaries from other versions of themselves by failing the link.
+	GLint status;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+bool get_program_binary(GLuint program, GLenum& format, std::vector<char>& binary)
+{
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return false;
+
+	GLsizei written = 0;
+	binary.resize(size);
+	glGetProgramBinary(program, size, &written, &format, &binary[0]);
+	binary.resize(written);
+	return written > 0;
 }
\ No newline at end of file
@@ -3,7 +3,14 @@
 #define NOMINMAX
 #include <GL/gl3w.h>
 #include <string>
+#include <vector>
 
 GLuint compile_shader_from_file(const std::string& filepath, GLenum shaderType);
 GLuint compile_shader_from_source(const char* source, GLenum shaderType);
-GLuint link_program(GLuint program);
\ No newline at end of file
+GLuint link_program(GLuint program);
+
+/* Create a program from a binary of get_program_binary(). Returns 0 if the driver does not accept it. */
+GLuint load_program_binary(GLenum format, const void* binary, GLsizei size);
+
+/* Get the binary of a linked program. Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking it. */
+bool get_program_binary(GLuint program, GLenum& format, std::vector<char>& binary);
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "simulation.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+
+const Simulation::Clock::duration Simulation::MAX_LAG = std::chrono::milliseconds(250);
+const Simulation::Clock::duration Simulation::PUBLISH_INTERVAL = std::chrono::milliseconds(4);
+const int Simulation::INPUT_QUEUE_SIZE = 256;
+const float Simulation::UNCAPPED = 0.0f;
+
+Simulation::Simulation(Car& car, CarBatch& fleet, JobPool& job_pool, Telemetry& telemetry, float dt)
+	: car(car)
+	, fleet(fleet)
+	, job_pool(job_pool)
+	, shared_telemetry(telemetry)
+	, dt(dt)
+	, tick_time_channel(-1)
+	, dropped_ticks_channel(-1)
+	, speed_channel(-1)
+	, dropped_tick_count(0)
+	, speed_tick_count(0)
+	, recording_format(STAT_FORMAT_COLUMNS)
+	, recording(nullptr)
+	, tick_count(0)
+	, inputs(INPUT_QUEUE_SIZE)
+	, stopping(false)
+	, time_scale(1.0f)
+	, failed(false)
+{
+
+}
+
+Simulation::~Simulation()
+{
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+
+	if (recording != nullptr)
+	{
+		try
+		{
+			recording->close();
+			if (recording->get_dropped_row_count() > 0)
+				std::cerr << "The recording " << recording_path << " is missing " << recording->get_dropped_row_count() << " ticks" << std::endl;
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+		}
+		delete recording;
+	}
+}
+
+void Simulation::record(const std::string& path, StatFormat format)
+{
+	recording_path = path;
+	recording_format = format;
+}
+
+void Simulation::start()
+{
+	tick_time_channel = shared_telemetry.register_channel("tick time", TELEMETRY_FLOAT, "Simulation tick: %.3f ms");
+	dropped_ticks_channel = shared_telemetry.register_channel("dropped ticks", TELEMETRY_INT, "Simulation ticks dropped: %d");
+	speed_channel = shared_telemetry.register_channel("simulation speed", TELEMETRY_FLOAT, "Simulation speed: %.2fx real time");
+	telemetry = shared_telemetry;
+	car.set_telemetry(&telemetry);
+	if (!recording_path.empty())
+		start_recording();
+
+	previous_snapshot.capture(car, fleet);
+	current_snapshot = previous_snapshot;
+
+	SimulationFrame frame;
+	frame.previous = previous_snapshot;
+	frame.current = current_snapshot;
+	frame.tick_time = Clock::now();
+	frame.tick_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(dt));
+	frame.telemetry = telemetry;
+	frames.reset(frame);
+	speed_time = frame.tick_time;
+	publish_time = frame.tick_time;
+
+	thread = std::thread(&Simulation::thread_main, this);
+}
+
+void Simulation::set_time_scale(float scale)
+{
+	time_scale = scale;
+}
+
+float Simulation::get_time_scale() const
+{
+	return time_scale;
+}
+
+void Simulation::send_input(const CarInput& input, Clock::time_point time)
+{
+	SimulationInput timed_input;
+	timed_input.time = time;
+	timed_input.car = input;
+	inputs.push(timed_input);
+}
+
+const SimulationFrame& Simulation::get_frame()
+{
+	if (failed)
+	{
+		std::lock_guard<std::mutex> lock(error_mutex);
+		throw std::runtime_error(error);
+	}
+
+	frames.consume();
+	return frames.get_read_buffer();
+}
+
+float Simulation::get_fixed_delta_time() const
+{
+	return dt;
+}
+
+void Simulation::thread_main()
+{
+	PROFILE_THREAD("simulation");
+	try
+	{
+		while (!stopping)
+		{
+			float scale = time_scale;
+			if (scale == UNCAPPED)
+				run_uncapped();
+			else
+				run_scaled(scale);
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::lock_guard<std::mutex> lock(error_mutex);
+		error = std::string("Simulation failed: ") + e.what();
+		failed = true;
+	}
+}
+
+void Simulation::run_scaled(float scale)
+{
+	// A ticker of its own for each time scale, with a tick due every dt / scale of wall clock time.
+	float period = dt / scale;
+	Clock::duration tick_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(period));
+	int max_ticks = std::max(1, static_cast<int>(std::chrono::duration<float>(MAX_LAG).count() / period));
+	Ticker ticker(period, max_ticks);
+	ticker.start();
+	while (!stopping && time_scale == scale)
+	{
+		std::this_thread::sleep_until(ticker.get_next_fixed_tick_time());
+		ticker.tick();
+		bool stepped = false;
+		while (!stopping && ticker.poll_fixed_tick())
+		{
+			step(ticker.get_fixed_tick_time(), tick_period);
+			stepped = true;
+			if (Clock::now() - publish_time >= PUBLISH_INTERVAL)
+			{
+				publish(ticker.get_fixed_tick_time(), tick_period);
+				stepped = false;
+			}
+		}
+
+		if (stepped)
+			publish(ticker.get_fixed_tick_time(), tick_period);
+		telemetry.set(dropped_ticks_channel, static_cast<int>(dropped_tick_count + ticker.get_dropped_tick_count()));
+	}
+
+	dropped_tick_count += ticker.get_dropped_tick_count();
+}
+
+void Simulation::run_uncapped()
+{
+	// Every tick is due as soon as the one before is done. Each gets an input change of its own at most.
+	const Clock::duration INPUT_PERIOD(1);
+	while (!stopping && time_scale == UNCAPPED)
+	{
+		Clock::time_point tick_time = Clock::now();
+		step(tick_time, INPUT_PERIOD);
+		if (tick_time - publish_time >= PUBLISH_INTERVAL)
+			publish(tick_time, Clock::duration::zero());
+	}
+}
+
+void Simulation::step(Clock::time_point tick_time, Clock::duration tick_period)
+{
+	PROFILE_SCOPE("tick");
+	Clock::time_point step_start = Clock::now();
+
+	// Apply the input from before the tick was due, in order. Late input that spans more than a tick
+	// is left for the next ones, so changes a tick apart stay a tick apart.
+	const SimulationInput* next_input = inputs.peek();
+	Clock::time_point first_input_time = next_input != nullptr ? next_input->time : tick_time;
+	while (next_input != nullptr && next_input->time <= tick_time && next_input->time - first_input_time < tick_period)
+	{
+		SimulationInput input;
+		inputs.pop(input);
+		car.handle_input(input.car);
+		for (int i = 0; i < fleet.get_car_count(); ++i)
+		{
+			fleet.handle_input(i, input.car);
+		}
+		next_input = inputs.peek();
+	}
+
+	{
+		PROFILE_SCOPE("player");
+		car.update(dt);
+	}
+	{
+		PROFILE_SCOPE("fleet");
+		fleet.update(dt, job_pool);
+	}
+	{
+		PROFILE_SCOPE("snapshot");
+		std::swap(previous_snapshot, current_snapshot);
+		current_snapshot.capture(car, fleet);
+	}
+	telemetry.set(tick_time_channel, std::chrono::duration<float, std::milli>(Clock::now() - step_start).count());
+
+	if (recording != nullptr)
+		record_tick();
+	tick_count++;
+	speed_tick_count++;
+}
+
+void Simulation::publish(Clock::time_point tick_time, Clock::duration tick_period)
+{
+	// Measure the speed over half a second or so, a single batch says little.
+	Clock::time_point now = Clock::now();
+	if (now - speed_time >= std::chrono::milliseconds(500))
+	{
+		telemetry.set(speed_channel, speed_tick_count * dt / std::chrono::duration<float>(now - speed_time).count());
+		speed_time = now;
+		speed_tick_count = 0;
+	}
+
+	SimulationFrame& frame = frames.get_write_buffer();
+	frame.previous = previous_snapshot;
+	frame.current = current_snapshot;
+	frame.tick_time = tick_time;
+	frame.tick_period = tick_period;
+	frame.telemetry.copy_values(telemetry);
+	frames.publish();
+	publish_time = now;
+}
+
+void Simulation::start_recording()
+{
+	recording = new StatFile(recording_path, recording_format);
+	recording->add_column("tick", STAT_INT);
+	recording->add_column("time", STAT_DOUBLE);
+
+	// One column per value of every channel, named after the channel with a space replaced by an underscore.
+	for (int i = 0; i < telemetry.get_channel_count(); ++i)
+	{
+		TelemetryType type = telemetry.get_type(i);
+		if (type == TELEMETRY_NONE)
+			continue;
+
+		std::string name = telemetry.get_key(i);
+		std::replace(name.begin(), name.end(), ' ', '_');
+		StatType stat_type = type == TELEMETRY_INT || type == TELEMETRY_INT2 ? STAT_INT : STAT_FLOAT;
+		int component_count = type == TELEMETRY_FLOAT2 || type == TELEMETRY_INT2 ? 2 : 1;
+		for (int k = 0; k < component_count; ++k)
+		{
+			recording->add_column(component_count == 1 ? name : name + (k == 0 ? "_x" : "_y"), stat_type);
+			recording_channels.push_back(i);
+			recording_components.push_back(k);
+		}
+	}
+
+	recording->start();
+}
+
+void Simulation::record_tick()
+{
+	PROFILE_SCOPE("record");
+	StatRow row;
+	row.set(0, static_cast<int>(tick_count));
+	row.set(1, static_cast<double>(tick_count) * dt);
+	for (int i = 0; i < recording_channels.size(); ++i)
+	{
+		if (telemetry.get_type(recording_channels[i]) == TELEMETRY_INT || telemetry.get_type(recording_channels[i]) == TELEMETRY_INT2)
+			row.set(i + 2, telemetry.get_int(recording_channels[i], recording_components[i]));
+		else
+			row.set(i + 2, telemetry.get_float(recording_channels[i], recording_components[i]));
+	}
+	recording->push(row);
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "car2d_sim/car.hpp"
+#include "car2d_sim/car_batch.hpp"
+#include "car2d_sim/job_pool.hpp"
+#include "car2d_sim/telemetry.hpp"
+#include "car2d_sim/ticker.hpp"
+#include "car2d_sim/triple_buffer.hpp"
+#include "car2d_sim/spsc_queue.hpp"
+#include "car2d_sim/profiler.hpp"
+#include "car2d_sim/stat_file.hpp"
+#include "render_snapshot.hpp"
+
+/* A change of the player's input, stamped with when it happened. */
+struct SimulationInput
+{
+	Ticker::Clock::time_point time;
+	CarInput car;
+};
+
+/* What the simulation publishes after every tick. */
+struct SimulationFrame
+{
+	RenderSnapshot previous;
+	RenderSnapshot current;
+	Ticker::Clock::time_point tick_time;		// When current was due. previous was due one tick earlier.
+	Ticker::Clock::duration tick_period;		// The wall clock time between ticks at the current time scale, zero when uncapped.
+	Telemetry telemetry;						// The values the cars wrote during the tick.
+};
+
+/*
+	Steps the player and the fleet on a thread of its own, at a fixed rate kept by the clock.
+
+	Input goes in through a queue and the state of every tick comes out through a triple buffer, so
+	neither the simulation nor the renderer ever waits for the other. A slow frame no longer slows the
+	simulation down; if the simulation itself falls more than MAX_LAG behind, e.g. after a breakpoint,
+	it skips ahead instead of trying to catch up, and counts the dropped ticks.
+
+	Each input carries the time it happened and applies from the first tick due after that. Input
+	that reaches the simulation after its tick already ran applies to the next tick, but changes that
+	happened a tick or more apart still go to different ticks, so a short tap is never pressed and
+	released within one tick.
+
+	The time scale sets how fast simulated time passes against the wall clock: below 1 for slow motion,
+	above for fast forward, where a tick is then due every dt / scale. UNCAPPED runs the ticks back to
+	back as fast as the thread can. The state is published after each batch of due ticks, and at least
+	every PUBLISH_INTERVAL during long ones, so however many ticks run per rendered frame, only the
+	newest is copied out.
+
+	The cars, the fleet and the job pool belong to the simulation thread from start() on. The renderer
+	only reads their descriptions, which never change. The telemetry channels must all be registered
+	before start(); the simulation then writes its own copy and every frame carries the values. With
+	record(), every tick also writes the telemetry of that tick as a row of a StatFile.
+
+	Usage:
+
+	Simulation simulation(car, fleet, job_pool, telemetry, 1.0f / 200.0f);
+	simulation.record("run.c2dstat", STAT_FORMAT_COLUMNS);
+	simulation.start();
+	simulation.set_time_scale(10.0f);
+	each frame:
+		simulation.send_input(input, time);
+		const SimulationFrame& frame = simulation.get_frame();
+*/
+class Simulation
+{
+public:
+	typedef Ticker::Clock Clock;
+
+	static const Clock::duration MAX_LAG;
+	static const Clock::duration PUBLISH_INTERVAL;
+	static const int INPUT_QUEUE_SIZE;
+	static const float UNCAPPED;
+
+	Simulation(Car& car, CarBatch& fleet, JobPool& job_pool, Telemetry& telemetry, float dt);
+	~Simulation();
+
+	/* Write the telemetry of every tick to the file, from start() on. Call before start(). */
+	void record(const std::string& path, StatFormat format);
+
+	/* Take a copy of the telemetry and start ticking. */
+	void start();
+
+	/* Set the simulated seconds per wall clock second, or UNCAPPED. Takes effect from the next tick. */
+	void set_time_scale(float scale);
+	float get_time_scale() const;
+
+	/* Queue input that happened at the given time. Dropped if the simulation is far behind. */
+	void send_input(const CarInput& input, Clock::time_point time);
+
+	/* The newest frame, without waiting. Rethrows on this thread if the simulation failed. */
+	const SimulationFrame& get_frame();
+
+	float get_fixed_delta_time() const;
+private:
+	Car& car;
+	CarBatch& fleet;
+	JobPool& job_pool;
+	Telemetry& shared_telemetry;
+	float dt;
+
+	// Only touched by the simulation thread once it runs.
+	Telemetry telemetry;
+	RenderSnapshot previous_snapshot;
+	RenderSnapshot current_snapshot;
+	int tick_time_channel;
+	int dropped_ticks_channel;
+	int speed_channel;
+	long long dropped_tick_count;				// By tickers of earlier time scales.
+	long long speed_tick_count;					// Ticks since speed_time.
+	Clock::time_point speed_time;
+	Clock::time_point publish_time;
+	std::string recording_path;
+	StatFormat recording_format;
+	StatFile* recording;
+	std::vector<int> recording_channels;		// The telemetry channel of each column after the tick columns.
+	std::vector<int> recording_components;
+	long long tick_count;
+
+	TripleBuffer<SimulationFrame> frames;
+	SpscQueue<SimulationInput> inputs;
+	std::thread thread;
+	std::atomic<bool> stopping;
+	std::atomic<float> time_scale;
+	std::atomic<bool> failed;
+	std::mutex error_mutex;
+	std::string error;
+
+	Simulation(const Simulation&);
+	Simulation& operator=(const Simulation&);
+
+	void start_recording();
+	void record_tick();
+	void thread_main();
+	void run_scaled(float scale);
+	void run_uncapped();
+	void step(Clock::time_point tick_time, Clock::duration tick_period);
+	void publish(Clock::time_point tick_time, Clock::duration tick_period);
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "stats.hpp"
 #include "config.hpp"
-#include "shader.hpp"
+#include <algorithm>
+#include <cstddef>
 
 const wchar_t* Stats::FONT_CHARSET_CACHE =
 	L" !\"#$%&'()*+,-./0123456789:;<=>?"
@@ -9,23 +10,38 @@ const wchar_t* Stats::FONT_CHARSET_CACHE =
 const float Stats::MARGIN_X = -0.95f;
 const float Stats::MARGIN_Y = 0.95f;
 
-Stats::Stats(int viewport_width, int viewport_height)
-	: texture_atlas(0)
+Stats::Stats(AssetCache& assets, int viewport_width, int viewport_height)
+	: visible(true)
+	, texture_atlas(0)
 	, texture_font(0)
-	, vertex_count(0)
-	, position_vbo(0)
-	, texcoord_vbo(0)
+	, vertex_buffer(0)
 	, vao(0)
+	, mapped_vertices(nullptr)
+	, section_capacity(0)
+	, section(0)
+	, vertex_count(0)
 	, sampler(0)
-	, text_vs(0)
-	, text_fs(0)
 	, text_program(0)
-	, uniform_instance_buffer(0)
 {
 	texture_atlas = texture_atlas_new(512, 512, 1);
 	texture_font = texture_font_new_from_file(texture_atlas, 11, (DIRECTORY_FONTS + FILE_DEFAULT_FONT).c_str());
 	texture_font_load_glyphs(texture_font, FONT_CHARSET_CACHE);
 
+	for (int i = 0; i < RING_SECTIONS; ++i)
+	{
+		section_fences[i] = 0;
+	}
+
+	// The vertex format is fixed, the buffer is attached once it is created.
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(TextVertex, position));
+	glVertexAttribBinding(0, 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(TextVertex, texcoord));
+	glVertexAttribBinding(1, 0);
+	glEnableVertexAttribArray(1);
+
 	// Create a sampler object for the font.
 	glGenSamplers(1, &sampler);
 	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -34,12 +50,7 @@ Stats::Stats(int viewport_width, int viewport_height)
 	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	// Load the shader program.
-	text_vs = compile_shader_from_file(DIRECTORY_SHADERS + FILE_TEXT_VS, GL_VERTEX_SHADER);
-	text_fs = compile_shader_from_file(DIRECTORY_SHADERS + FILE_TEXT_FS, GL_FRAGMENT_SHADER);
-	text_program = glCreateProgram();
-	glAttachShader(text_program, text_vs);
-	glAttachShader(text_program, text_fs);
-	link_program(text_program);
+	text_program = assets.get_program(DIRECTORY_SHADERS + FILE_TEXT_VS, DIRECTORY_SHADERS + FILE_TEXT_FS);
 
 	// Setup a scale matrix to go from screen space to normalized device space.
 	glm::mat3 scale(2.0f / viewport_width, 0.0f,				   0.0f,
@@ -51,150 +62,73 @@ Stats::Stats(int viewport_width, int viewport_height)
 						  MARGIN_X, MARGIN_Y, 1.0f);
 	uniform_instance_data.model_matrix = glm::mat3x4(translation * scale);
 	uniform_instance_data.color = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
-
-	glGenBuffers(1, &uniform_instance_buffer);
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_INSTANCE_BINDING, uniform_instance_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(TextPerInstance), &uniform_instance_data, GL_DYNAMIC_DRAW);
 }
 
 Stats::~Stats()
 {
 	texture_atlas_delete(texture_atlas);
 
-	glDetachShader(text_program, text_vs);
-	glDetachShader(text_program, text_fs);
-	glDeleteShader(text_vs);
-	glDeleteShader(text_fs);
-	glDeleteProgram(text_program);
-
 	glDeleteSamplers(1, &sampler);
 
-	glDeleteBuffers(1, &position_vbo);
-	glDeleteBuffers(1, &texcoord_vbo);
+	for (int i = 0; i < RING_SECTIONS; ++i)
+	{
+		glDeleteSync(section_fences[i]);
+	}
+	if (vertex_buffer != 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glDeleteBuffers(1, &vertex_buffer);
+	}
 	glDeleteVertexArrays(1, &vao);
-
-	glDeleteBuffers(1, &uniform_instance_buffer);
 }
 
-void Stats::append_update_line(const std::string& key, const char* format, ...)
+void Stats::update_text(const Telemetry& telemetry)
 {
-	// Find an existing line or append a new line.
-	int i = 0;
-	for (; i < lines.size(); ++i)
-	{
-		if (lines[i].key == key)
-			break;
-	}
+	PROFILE_SCOPE("stats text");
+	if (!visible)
+		return;
 
-	if (i == lines.size())
-	{
-		lines.push_back(Line());
-		lines[i].key = key;
-	}
+	// Format the telemetry and lay out the lines that changed.
+	int line_count = telemetry.get_channel_count();
+	bool changed = line_count != lines.size();
+	lines.resize(line_count);
 
-	// Update the text.
-	char buffer[512];
-	va_list v;
-	va_start(v, format);
-	if (vsprintf_s(buffer, format, v) < 0)
+	for (int i = 0; i < line_count; ++i)
 	{
-		va_end(v);
-		throw std::runtime_error("Failed to append/update stats line: buffer error");
+		char buffer[256];
+		int length = telemetry.format(i, buffer, sizeof(buffer));
+		changed = set_line(i, buffer, length) || changed;
 	}
-	va_end(v);
 
-	// Copy the buffer.
-	lines[i].text = buffer;
+	if (changed)
+		upload_lines();
 }
 
-void Stats::update_text()
+void Stats::update_text(const Telemetry& telemetry, const Profiler& profiler)
 {
-	// Destroy any old vertex buffers.
-	glDeleteBuffers(1, &position_vbo);
-	glDeleteBuffers(1, &texcoord_vbo);
-	glDeleteVertexArrays(1, &vao);
-	vertex_count = 0;
-
-	// Bail out if we do not have any text.
-	if (lines.size() == 0)
+	PROFILE_SCOPE("stats text");
+	if (!visible)
 		return;
 
-	// Count the number of vertices.
-	for (int i = 0; i < lines.size(); ++i)
-	{
-		vertex_count += lines[i].text.size() * 6;
-	}
+	int telemetry_line_count = telemetry.get_channel_count();
+	int line_count = telemetry_line_count + profiler.get_line_count();
+	bool changed = line_count != lines.size();
+	lines.resize(line_count);
 
-	// Generate the new vertices.
-	glm::vec2 pen;
-	std::vector<glm::vec2> positions(vertex_count);
-	std::vector<glm::vec2> texcoords(vertex_count);
-	int offset = 0;
-	for (int i = 0; i < lines.size(); ++i)
+	for (int i = 0; i < line_count; ++i)
 	{
-		const std::string& text = lines[i].text;
-		int text_length = text.size();
-
-		pen.x = 0;
-		for (int k = 0; k < text_length; ++k)
-		{
-			wchar_t c = (wchar_t) text[k];
-			texture_glyph_t* glyph = texture_font_get_glyph(texture_font, c);
-
-			float kerning = 0.0f;
-			if (k > 0)
-			{
-				kerning = texture_glyph_get_kerning(glyph, text[k - 1]);
-			}
-
-			pen.x += kerning;
-
-			float x0 = pen.x + glyph->offset_x;
-			float y0 = pen.y + glyph->offset_y;
-			float x1 = x0 + glyph->width;
-			float y1 = y0 - glyph->height;
-
-			positions[offset + k * 6 + 0] = glm::vec2(x0, y0);
-			positions[offset + k * 6 + 1] = glm::vec2(x0, y1);
-			positions[offset + k * 6 + 2] = glm::vec2(x1, y1);
-			positions[offset + k * 6 + 3] = glm::vec2(x0, y0);
-			positions[offset + k * 6 + 4] = glm::vec2(x1, y1);
-			positions[offset + k * 6 + 5] = glm::vec2(x1, y0);
-
-			float s0 = glyph->s0;
-			float t0 = glyph->t0;
-			float s1 = glyph->s1;
-			float t1 = glyph->t1;
-
-			texcoords[offset + k * 6 + 0] = glm::vec2(s0, t0);
-			texcoords[offset + k * 6 + 1] = glm::vec2(s0, t1);
-			texcoords[offset + k * 6 + 2] = glm::vec2(s1, t1);
-			texcoords[offset + k * 6 + 3] = glm::vec2(s0, t0);
-			texcoords[offset + k * 6 + 4] = glm::vec2(s1, t1);
-			texcoords[offset + k * 6 + 5] = glm::vec2(s1, t0);
-
-			pen.x += glyph->advance_x;
-		}
-
-		pen.y -= (texture_font->ascender - texture_font->descender) + texture_font->linegap;
-		offset += text_length * 6;
+		char buffer[256];
+		int length = 0;
+		if (i < telemetry_line_count)
+			length = telemetry.format(i, buffer, sizeof(buffer));
+		else
+			length = profiler.format_line(i - telemetry_line_count, buffer, sizeof(buffer));
+		changed = set_line(i, buffer, length) || changed;
 	}
 
-	// Generate new vertex buffers.
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	glGenBuffers(1, &position_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, position_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * vertex_count, &positions[0], GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(0);
-
-	glGenBuffers(1, &texcoord_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, texcoord_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * vertex_count, &texcoords[0], GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(1);
+	if (changed)
+		upload_lines();
 }
 
 void Stats::window_resized(int viewport_width, int viewport_height)
@@ -208,21 +142,18 @@ void Stats::window_resized(int viewport_width, int viewport_height)
 						  0.0f,		1.0f,	  0.0f,
 						  MARGIN_X, MARGIN_Y, 1.0f);
 	uniform_instance_data.model_matrix = glm::mat3x4(translation * scale);
-
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_INSTANCE_BINDING, uniform_instance_buffer);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(TextPerInstance), &uniform_instance_data);
 }
 
-void Stats::render()
+void Stats::render(UniformRing& uniforms)
 {
-	if (vertex_count == 0)
+	if (!visible || vertex_count == 0)
 		return;
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 	glUseProgram(text_program);
 
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_INSTANCE_BINDING, uniform_instance_buffer);
+	uniforms.bind(UNIFORM_INSTANCE_BINDING, uniform_instance_data);
 
 	glActiveTexture(GL_TEXTURE0 + TEXTURE_DIFFUSE_BINDING);
 	glBindSampler(TEXTURE_DIFFUSE_BINDING, sampler);
@@ -231,5 +162,156 @@ void Stats::render()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	glBindVertexArray(vao);
-	glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+	glDrawArrays(GL_TRIANGLES, section * section_capacity, vertex_count);
+
+	if (section_fences[section] != 0)
+		glDeleteSync(section_fences[section]);
+	section_fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void Stats::set_visible(bool visible)
+{
+	this->visible = visible;
+}
+
+void Stats::toggle_visible()
+{
+	visible = !visible;
+}
+
+bool Stats::is_visible() const
+{
+	return visible;
+}
+
+bool Stats::set_line(int index, const char* text, int length)
+{
+	Line& line = lines[index];
+	if (line.text.size() == length && line.text.compare(0, length, text, length) == 0)
+		return false;
+
+	line.text.assign(text, length);
+	layout_line(index);
+	return true;
+}
+
+void Stats::upload_lines()
+{
+	int line_count = static_cast<int>(lines.size());
+	vertex_count = 0;
+	for (int i = 0; i < line_count; ++i)
+	{
+		vertex_count += static_cast<int>(lines[i].vertices.size());
+	}
+
+	if (vertex_count == 0)
+		return;
+
+	reserve_sections(vertex_count);
+
+	// Write the next section, once the GPU is done drawing from it.
+	section = (section + 1) % RING_SECTIONS;
+	if (section_fences[section] != 0)
+	{
+		while (glClientWaitSync(section_fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(section_fences[section]);
+		section_fences[section] = 0;
+	}
+
+	TextVertex* vertices = mapped_vertices + section * section_capacity;
+	for (int i = 0; i < line_count; ++i)
+	{
+		vertices = std::copy(lines[i].vertices.begin(), lines[i].vertices.end(), vertices);
+	}
+}
+
+void Stats::layout_line(int index)
+{
+	Line& line = lines[index];
+	const std::string& text = line.text;
+	int text_length = text.size();
+	line.vertices.resize(text_length * 6);
+
+	glm::vec2 pen(0.0f, -index * ((texture_font->ascender - texture_font->descender) + texture_font->linegap));
+	for (int k = 0; k < text_length; ++k)
+	{
+		wchar_t c = (wchar_t) text[k];
+		texture_glyph_t* glyph = texture_font_get_glyph(texture_font, c);
+
+		float kerning = 0.0f;
+		if (k > 0)
+		{
+			kerning = texture_glyph_get_kerning(glyph, text[k - 1]);
+		}
+
+		pen.x += kerning;
+
+		float x0 = pen.x + glyph->offset_x;
+		float y0 = pen.y + glyph->offset_y;
+		float x1 = x0 + glyph->width;
+		float y1 = y0 - glyph->height;
+
+		float s0 = glyph->s0;
+		float t0 = glyph->t0;
+		float s1 = glyph->s1;
+		float t1 = glyph->t1;
+
+		TextVertex* vertices = &line.vertices[k * 6];
+		vertices[0].position = glm::vec2(x0, y0);
+		vertices[1].position = glm::vec2(x0, y1);
+		vertices[2].position = glm::vec2(x1, y1);
+		vertices[3].position = glm::vec2(x0, y0);
+		vertices[4].position = glm::vec2(x1, y1);
+		vertices[5].position = glm::vec2(x1, y0);
+
+		vertices[0].texcoord = glm::vec2(s0, t0);
+		vertices[1].texcoord = glm::vec2(s0, t1);
+		vertices[2].texcoord = glm::vec2(s1, t1);
+		vertices[3].texcoord = glm::vec2(s0, t0);
+		vertices[4].texcoord = glm::vec2(s1, t1);
+		vertices[5].texcoord = glm::vec2(s1, t0);
+
+		pen.x += glyph->advance_x;
+	}
 }
+
+void Stats::reserve_sections(int vertex_count)
+{
+	if (vertex_count <= section_capacity)
+		return;
+
+	// Replace the buffer with one twice the size. Everything drawn from the old one must finish first.
+	for (int i = 0; i < RING_SECTIONS; ++i)
+	{
+		if (section_fences[i] != 0)
+		{
+			glClientWaitSync(section_fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(section_fences[i]);
+			section_fences[i] = 0;
+		}
+	}
+
+	if (vertex_buffer != 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glDeleteBuffers(1, &vertex_buffer);
+	}
+
+	section_capacity = std::max(section_capacity, 1024);
+	while (section_capacity < vertex_count)
+	{
+		section_capacity *= 2;
+	}
+	section = 0;
+
+	GLsizeiptr size = sizeof(TextVertex) * section_capacity * RING_SECTIONS;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &vertex_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+	mapped_vertices = static_cast<TextVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+
+	glBindVertexArray(vao);
+	glBindVertexBuffer(0, vertex_buffer, 0, sizeof(TextVertex));
+}
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <string>
 #include <glm/glm.hpp>
 #include <freetype-gl/freetype-gl.h>
-
-class Car;
+#include "car2d_sim/telemetry.hpp"
+#include "car2d_sim/profiler.hpp"
+#include "asset_cache.hpp"
+#include "uniform_ring.hpp"
 
 struct TextPerInstance
 {
@@ -12,38 +15,68 @@ struct TextPerInstance
 	glm::vec4 color;
 };
 
+struct TextVertex
+{
+	glm::vec2 position;
+	glm::vec2 texcoord;
+};
+
+/*
+	The debug overlay. Lists every telemetry channel, one per line.
+
+	Formatting and building the text mesh is by far the most expensive part, so update_text() is meant
+	to be called once per rendered frame and only while the overlay is visible. Only the lines whose
+	text changed are laid out again, and the vertices go into a persistently mapped buffer split into
+	RING_SECTIONS sections, so a frame writes one section while the GPU may still draw the ones before.
+	Once the buffer is large enough nothing is allocated, on the heap or in GL, apart from the fence
+	each drawn frame leaves behind to guard its section.
+*/
 class Stats
 {
 public:
-	Stats(int viewport_width, int viewport_height);
+	Stats(AssetCache& assets, int viewport_width, int viewport_height);
 	~Stats();
 
-	void append_update_line(const std::string& key, const char* format, ...);
-	void update_text();
+	/* Format the current telemetry values and rebuild the text. Does nothing while hidden. */
+	void update_text(const Telemetry& telemetry);
+
+	/* Same as above, followed by the scopes of the profiler. */
+	void update_text(const Telemetry& telemetry, const Profiler& profiler);
 	void window_resized(int viewport_width, int viewport_height);
-	void render();
+	void render(UniformRing& uniforms);
+
+	void set_visible(bool visible);
+	void toggle_visible();
+	bool is_visible() const;
 private:
+	static const wchar_t* Stats::FONT_CHARSET_CACHE;
+	static const float MARGIN_X;
+	static const float MARGIN_Y;
+	static const int RING_SECTIONS = 3;
+
 	struct Line
 	{
-		std::string key;
 		std::string text;
+		std::vector<TextVertex> vertices;
 	};
 
-	static const wchar_t* Stats::FONT_CHARSET_CACHE;
-	static const float MARGIN_X;
-	static const float MARGIN_Y;
-
-	std::vector<Line> lines;
+	bool visible;
+	std::vector<Line> lines;					// Kept between frames so the strings and vertices keep their capacity.
 	texture_atlas_t* texture_atlas;
 	texture_font_t* texture_font;
-	size_t vertex_count;
-	GLuint position_vbo;
-	GLuint texcoord_vbo;
+	GLuint vertex_buffer;
 	GLuint vao;
+	TextVertex* mapped_vertices;				// The whole buffer, mapped for as long as it lives.
+	int section_capacity;						// In vertices.
+	int section;								// The section drawn by render().
+	GLsync section_fences[RING_SECTIONS];		// Signalled when the GPU is done with the section.
+	int vertex_count;
 	GLuint sampler;
-	GLuint text_vs;
-	GLuint text_fs;
 	GLuint text_program;
-	GLuint uniform_instance_buffer;
 	TextPerInstance uniform_instance_data;
+
+	bool set_line(int index, const char* text, int length);
+	void upload_lines();
+	void layout_line(int index);
+	void reserve_sections(int vertex_count);
 };
\ No newline at end of file
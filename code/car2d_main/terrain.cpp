@@ -1,8 +1,6 @@
 #include "terrain.hpp"
-#include <gli/gli.hpp>
-#include "shader.hpp"
 
-Terrain::Terrain(const YAML::Node& map_file)
+Terrain::Terrain(AssetCache& assets, const YAML::Node& map_file)
 {
 	float scale = map_file["GroundTextureScale"].as<float>();
 	glm::mat3 model = glm::mat3(scale, 0,	   0,
@@ -14,10 +12,6 @@ Terrain::Terrain(const YAML::Node& map_file)
 	uniform_instance_data.model_matrix = glm::mat3x4(model);
 	uniform_instance_data.bias_matrix = glm::mat3x4(bias);
 
-	glGenBuffers(1, &uniform_instance_buffer);
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_INSTANCE_BINDING, uniform_instance_buffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(TerrainPerInstance), &uniform_instance_data, GL_STATIC_DRAW);
-
 	glm::vec2 positions[] = { glm::vec2(-1.0f, 1.0f), glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, -1.0f) };
 	glm::vec2 texcoords[] = { glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, 0.0f) };
 
@@ -42,44 +36,27 @@ Terrain::Terrain(const YAML::Node& map_file)
 	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	gli::storage teximage = gli::load_dds(DIRECTORY_TEXTURES + map_file["GroundTexture"].as<std::string>());
-
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, teximage.dimensions(0).x, teximage.dimensions(0).y, 0, GL_BGR, GL_UNSIGNED_BYTE, teximage.data());
+	texture = assets.get_texture(DIRECTORY_TEXTURES + map_file["GroundTexture"].as<std::string>());
 
-	terrain_vs = compile_shader_from_file(DIRECTORY_SHADERS + FILE_TERRAIN_VS, GL_VERTEX_SHADER);
-	terrain_fs = compile_shader_from_file(DIRECTORY_SHADERS + FILE_TERRAIN_FS, GL_FRAGMENT_SHADER);
-	terrain_program = glCreateProgram();
-	glAttachShader(terrain_program, terrain_vs);
-	glAttachShader(terrain_program, terrain_fs);
-	link_program(terrain_program);
+	terrain_program = assets.get_program(DIRECTORY_SHADERS + FILE_TERRAIN_VS, DIRECTORY_SHADERS + FILE_TERRAIN_FS);
 }
 
 Terrain::~Terrain()
 {
-	glDetachShader(terrain_program, terrain_vs);
-	glDetachShader(terrain_program, terrain_fs);
-	glDeleteShader(terrain_vs);
-	glDeleteShader(terrain_fs);
-	glDeleteProgram(terrain_program);
 
 	glDeleteSamplers(1, &sampler);
-	glDeleteTextures(1, &texture);
 	
 	glDeleteVertexArrays(1, &quad_vao);
 	glDeleteBuffers(1, &quad_position_vbo);
 	glDeleteBuffers(1, &quad_texcoord_vbo);
-
-	glDeleteBuffers(1, &uniform_instance_buffer);
 }
 
-void Terrain::render()
+void Terrain::render(UniformRing& uniforms)
 {
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	
 	glUseProgram(terrain_program);
-	glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_INSTANCE_BINDING, uniform_instance_buffer);
+	uniforms.bind(UNIFORM_INSTANCE_BINDING, uniform_instance_data);
 	
 	glActiveTexture(GL_TEXTURE0 + TEXTURE_DIFFUSE_BINDING);
 	glBindSampler(TEXTURE_DIFFUSE_BINDING, sampler);
@@ -6,6 +6,8 @@
 #include <GL/gl3w.h>
 #include "camera.hpp"
 #include "config.hpp"
+#include "asset_cache.hpp"
+#include "uniform_ring.hpp"
 
 struct TerrainPerInstance
 {
@@ -16,19 +18,16 @@ struct TerrainPerInstance
 class Terrain
 {
 public:
-	Terrain(const YAML::Node& map_file);
+	Terrain(AssetCache& assets, const YAML::Node& map_file);
 	~Terrain();
 
-	void render();
+	void render(UniformRing& uniforms);
 private:
 	TerrainPerInstance uniform_instance_data;
-	GLuint uniform_instance_buffer;
 	GLuint quad_position_vbo;
 	GLuint quad_texcoord_vbo;
 	GLuint quad_vao;
 	GLuint texture;
 	GLuint sampler;
-	GLuint terrain_vs;
-	GLuint terrain_fs;
 	GLuint terrain_program;
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "uniform_ring.hpp"
+#include <stdexcept>
+#include <cstring>
+
+UniformRing::UniformRing(int frame_size, int frame_count)
+	: buffer(0)
+	, mapped_data(nullptr)
+	, frame_size(frame_size)
+	, frame_count(frame_count)
+	, alignment(256)
+	, frame(0)
+	, frame_used(0)
+	, frame_fences(new GLsync[frame_count])
+{
+	for (int i = 0; i < frame_count; ++i)
+	{
+		frame_fences[i] = 0;
+	}
+
+	// Every bound range has to start at a multiple of the alignment, so the sections do too.
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	this->frame_size = (frame_size + alignment - 1) / alignment * alignment;
+
+	GLsizeiptr size = static_cast<GLsizeiptr>(this->frame_size) * frame_count;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+	mapped_data = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+}
+
+UniformRing::~UniformRing()
+{
+	for (int i = 0; i < frame_count; ++i)
+	{
+		glDeleteSync(frame_fences[i]);
+	}
+	delete[] frame_fences;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glUnmapBuffer(GL_UNIFORM_BUFFER);
+	glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::begin_frame()
+{
+	frame = (frame + 1) % frame_count;
+	frame_used = 0;
+
+	if (frame_fences[frame] != 0)
+	{
+		while (glClientWaitSync(frame_fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(frame_fences[frame]);
+		frame_fences[frame] = 0;
+	}
+}
+
+void UniformRing::end_frame()
+{
+	if (frame_fences[frame] != 0)
+		glDeleteSync(frame_fences[frame]);
+	frame_fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UniformRing::bind(GLuint binding, const void* data, size_t size)
+{
+	int offset = (frame_used + alignment - 1) / alignment * alignment;
+	if (offset + size > frame_size)
+		throw std::runtime_error("The uniform ring is out of space for this frame");
+
+	GLintptr buffer_offset = static_cast<GLintptr>(frame) * frame_size + offset;
+	std::memcpy(mapped_data + buffer_offset, data, size);
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, buffer_offset, size);
+	frame_used = offset + static_cast<int>(size);
+}
\ No newline at end of file
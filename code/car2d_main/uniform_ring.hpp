@@ -0,0 +1,55 @@
+#pragma once
+
+#define NOMINMAX
+#include <GL/gl3w.h>
+#include <cstddef>
+
+/*
+	Hands out uniform data for the frame being recorded from one persistently mapped buffer.
+
+	The buffer is split into frame_count sections. Each frame writes its uniform blocks into the next
+	section and binds them with glBindBufferRange, so nothing the GPU may still be reading is
+	overwritten and no upload waits on the driver. end_frame() fences the section, and begin_frame()
+	waits on that fence before the section is reused frame_count frames later.
+
+	Usage:
+
+	uniforms.begin_frame();
+	uniforms.bind(UNIFORM_FRAME_BINDING, uniform_frame_data);
+	draw
+	uniforms.end_frame();
+*/
+class UniformRing
+{
+public:
+	/* frame_size is the most bytes of uniform data, including alignment, that one frame can use. */
+	UniformRing(int frame_size, int frame_count);
+	~UniformRing();
+
+	/* Start writing the next section, waiting for the GPU if it is still reading it. */
+	void begin_frame();
+
+	/* Fence the section. Call after the last draw of the frame. */
+	void end_frame();
+
+	/* Copy the block into this frame's section and bind it. Throws if the section is full. */
+	void bind(GLuint binding, const void* data, size_t size);
+
+	template <typename T>
+	void bind(GLuint binding, const T& data)
+	{
+		bind(binding, &data, sizeof(T));
+	}
+private:
+	GLuint buffer;
+	unsigned char* mapped_data;					// The whole buffer, mapped for as long as it lives.
+	int frame_size;
+	int frame_count;
+	int alignment;								// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	int frame;									// The section being written.
+	int frame_used;								// Bytes used in the section so far.
+	GLsync* frame_fences;						// Signalled when the GPU is done with the section.
+
+	UniformRing(const UniformRing&);
+	UniformRing& operator=(const UniformRing&);
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "car2d_sim/map.hpp"
+
+/*
+	Compiles maps into the binary form Map loads without parsing. Each map is written next to itself,
+	maps/test_map.yaml to maps/test_map.c2dmap, and the tiles of a tiled map are compiled along with it.
+
+	Usage: car2d_mapc <map.yaml> [<map.yaml> ...]
+*/
+
+typedef std::chrono::steady_clock Clock;
+
+static std::string get_directory(const std::string& path)
+{
+	std::string::size_type slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+static void compile_map(const std::string& path)
+{
+	Clock::time_point start = Clock::now();
+	std::string compiled_path = Map::get_compiled_path(path);
+	Map::compile(path, compiled_path);
+
+	// Read it back, which also checks that it is accepted.
+	Map map(path);
+	if (!map.is_compiled())
+		throw std::runtime_error("The compiled map " + compiled_path + " was not accepted");
+
+	std::cout << path << " -> " << compiled_path << " (" << std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count() << " ms)" << std::endl;
+
+	if (map.is_tiled())
+	{
+		std::string directory = get_directory(path);
+		const std::vector<MapTile>& tiles = map.get_tiles();
+		for (int i = 0; i < tiles.size(); ++i)
+		{
+			std::string tile_path = directory + tiles[i].file;
+			Map::compile(tile_path, Map::get_compiled_path(tile_path));
+		}
+
+		std::cout << "Compiled " << tiles.size() << " tiles" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: car2d_mapc <map.yaml> [<map.yaml> ...]" << std::endl;
+		return 1;
+	}
+
+	int result = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		try
+		{
+			compile_map(argv[i]);
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << "Failed to compile " << argv[i] << ": " << e.what() << std::endl;
+			result = 1;
+		}
+	}
+
+	return result;
+}
\ No newline at end of file
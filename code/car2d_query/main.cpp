@@ -0,0 +1,548 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <emmintrin.h>
+#include "car2d_sim/stat_reader.hpp"
+#include "car2d_sim/job_pool.hpp"
+
+/*
+	Answers questions about recorded telemetry, such as the time spent above 6000 rpm or the share of
+	each minute the rear wheels slipped, by scanning the columnar files written by StatFile.
+
+	Only the columns asked for are decoded, chunk by chunk on every core, and the aggregations run
+	over plain arrays with SSE2: floats for float columns, doubles for int and double columns so they
+	stay exact. Without any --column the columns of each file are listed.
+
+	Usage: car2d_query [options] <run.c2dstat> [<run.c2dstat> ...]
+
+	--column <name>         Aggregate this column. May be given more than once.
+	--window <seconds>      Aggregate over windows of the time column instead of the whole run.
+	--group <column>        Aggregate over each run of rows where the column keeps its value, e.g. a lap.
+	--above <value>         Also report the time each column spends above the value.
+	--percentiles <list>    Comma separated percentiles to report, 50,95,99 by default.
+	--histogram <bins>      Also print a histogram of each column with this many bins.
+	--threads <count>       The threads decoding and aggregating. 0, the default, uses one per core.
+*/
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+	std::vector<std::string> files;
+	std::vector<std::string> columns;
+	float window;								// (s) Zero for the whole run.
+	std::string group;
+	bool has_threshold;
+	float threshold;
+	std::vector<float> percentiles;
+	int histogram_bins;
+	int thread_count;
+
+	Options()
+		: window(0.0f)
+		, has_threshold(false)
+		, threshold(0.0f)
+		, histogram_bins(0)
+		, thread_count(0)
+	{
+		percentiles.push_back(50.0f);
+		percentiles.push_back(95.0f);
+		percentiles.push_back(99.0f);
+	}
+};
+
+/* What summarize() finds in a range of values. */
+struct Summary
+{
+	long long count;
+	double min;
+	double max;
+	double sum;
+	long long above;							// The number of values above the threshold.
+	long long non_finite;						// NaNs and infinities, left out of everything else.
+};
+
+static void summarize(const float* values, int count, float threshold, Summary& summary)
+{
+	// Four lanes of min, max and above counts, and the sum in doubles so long runs do not lose precision.
+	__m128 min = _mm_set1_ps(INFINITY);
+	__m128 max = _mm_set1_ps(-INFINITY);
+	__m128d sum_low = _mm_setzero_pd();
+	__m128d sum_high = _mm_setzero_pd();
+	__m128i above = _mm_setzero_si128();
+	__m128 limit = _mm_set1_ps(threshold);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(values + i);
+		min = _mm_min_ps(min, x);
+		max = _mm_max_ps(max, x);
+		sum_low = _mm_add_pd(sum_low, _mm_cvtps_pd(x));
+		sum_high = _mm_add_pd(sum_high, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+
+		// The comparison gives -1 in the lanes above, subtracting counts them.
+		above = _mm_sub_epi32(above, _mm_castps_si128(_mm_cmpgt_ps(x, limit)));
+	}
+
+	float min_lanes[4];
+	float max_lanes[4];
+	double sum_lanes[4];
+	int above_lanes[4];
+	_mm_storeu_ps(min_lanes, min);
+	_mm_storeu_ps(max_lanes, max);
+	_mm_storeu_pd(sum_lanes, sum_low);
+	_mm_storeu_pd(sum_lanes + 2, sum_high);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(above_lanes), above);
+
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		summary.min = std::min(summary.min, static_cast<double>(min_lanes[lane]));
+		summary.max = std::max(summary.max, static_cast<double>(max_lanes[lane]));
+		summary.sum += sum_lanes[lane];
+		summary.above += above_lanes[lane];
+	}
+
+	for (; i < count; ++i)
+	{
+		summary.min = std::min(summary.min, static_cast<double>(values[i]));
+		summary.max = std::max(summary.max, static_cast<double>(values[i]));
+		summary.sum += values[i];
+		summary.above += values[i] > threshold ? 1 : 0;
+	}
+	summary.count += count;
+}
+
+/* The same for int and double columns, two at a time, so ints beyond the 24 bits of a float stay exact. */
+static void summarize(const double* values, int count, float threshold, Summary& summary)
+{
+	__m128d min = _mm_set1_pd(INFINITY);
+	__m128d max = _mm_set1_pd(-INFINITY);
+	__m128d sum = _mm_setzero_pd();
+	__m128i above = _mm_setzero_si128();
+	__m128d limit = _mm_set1_pd(threshold);
+
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(values + i);
+		min = _mm_min_pd(min, x);
+		max = _mm_max_pd(max, x);
+		sum = _mm_add_pd(sum, x);
+		above = _mm_sub_epi64(above, _mm_castpd_si128(_mm_cmpgt_pd(x, limit)));
+	}
+
+	double min_lanes[2];
+	double max_lanes[2];
+	double sum_lanes[2];
+	long long above_lanes[2];
+	_mm_storeu_pd(min_lanes, min);
+	_mm_storeu_pd(max_lanes, max);
+	_mm_storeu_pd(sum_lanes, sum);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(above_lanes), above);
+
+	for (int lane = 0; lane < 2; ++lane)
+	{
+		summary.min = std::min(summary.min, min_lanes[lane]);
+		summary.max = std::max(summary.max, max_lanes[lane]);
+		summary.sum += sum_lanes[lane];
+		summary.above += above_lanes[lane];
+	}
+
+	for (; i < count; ++i)
+	{
+		summary.min = std::min(summary.min, values[i]);
+		summary.max = std::max(summary.max, values[i]);
+		summary.sum += values[i];
+		summary.above += values[i] > threshold ? 1 : 0;
+	}
+	summary.count += count;
+}
+
+static void histogram(const float* values, int count, float low, float high, std::vector<long long>& bins)
+{
+	// Find the bins four at a time, clamping in float since SSE2 has no integer min and max.
+	int bin_count = static_cast<int>(bins.size());
+	float scale = high > low ? bin_count / (high - low) : 0.0f;
+	__m128 offset = _mm_set1_ps(low);
+	__m128 factor = _mm_set1_ps(scale);
+	__m128 last = _mm_set1_ps(static_cast<float>(bin_count - 1));
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 position = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), offset), factor);
+		position = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), last);
+
+		int indices[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(position));
+		bins[indices[0]]++;
+		bins[indices[1]]++;
+		bins[indices[2]]++;
+		bins[indices[3]]++;
+	}
+
+	// The same comparisons as maxps and minps, which turn a NaN into bin 0 where std::max would pass it on.
+	for (; i < count; ++i)
+	{
+		float position = (values[i] - low) * scale;
+		position = position > 0.0f ? position : 0.0f;
+		position = position < bin_count - 1 ? position : static_cast<float>(bin_count - 1);
+		bins[static_cast<int>(position)]++;
+	}
+}
+
+static void histogram(const double* values, int count, double low, double high, std::vector<long long>& bins)
+{
+	int bin_count = static_cast<int>(bins.size());
+	double scale = high > low ? bin_count / (high - low) : 0.0;
+	__m128d offset = _mm_set1_pd(low);
+	__m128d factor = _mm_set1_pd(scale);
+	__m128d last = _mm_set1_pd(static_cast<double>(bin_count - 1));
+
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d position = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(values + i), offset), factor);
+		position = _mm_min_pd(_mm_max_pd(position, _mm_setzero_pd()), last);
+
+		int indices[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttpd_epi32(position));
+		bins[indices[0]]++;
+		bins[indices[1]]++;
+	}
+
+	for (; i < count; ++i)
+	{
+		double position = (values[i] - low) * scale;
+		position = position > 0.0 ? position : 0.0;
+		position = position < bin_count - 1 ? position : static_cast<double>(bin_count - 1);
+		bins[static_cast<int>(position)]++;
+	}
+}
+
+/* The nearest rank percentiles of the values, which must all be finite, reordering them. The percentiles must be in increasing order. */
+template <typename Value>
+static void find_percentiles(std::vector<Value>& sorted, const std::vector<float>& percentiles, std::vector<double>& results)
+{
+	results.assign(percentiles.size(), NAN);
+	int count = static_cast<int>(sorted.size());
+	if (count == 0)
+		return;
+
+	// Each selection leaves everything above it to the right, so the next only has to look there.
+	typename std::vector<Value>::iterator begin = sorted.begin();
+	for (int i = 0; i < percentiles.size(); ++i)
+	{
+		int rank = static_cast<int>(std::ceil(percentiles[i] / 100.0f * count)) - 1;
+		rank = std::min(std::max(rank, 0), count - 1);
+		typename std::vector<Value>::iterator nth = sorted.begin() + rank;
+		if (nth >= begin)
+		{
+			std::nth_element(begin, nth, sorted.end());
+			begin = nth;
+		}
+		results[i] = *nth;
+	}
+}
+
+/* A range of rows aggregated together. */
+struct Window
+{
+	long long begin;
+	long long end;
+	std::string label;
+};
+
+static std::string format_number(double value, int precision = 6)
+{
+	std::ostringstream ss;
+	ss << std::setprecision(precision) << value;
+	return ss.str();
+}
+
+static std::vector<Window> find_windows(const Options& options, const std::vector<double>& times, const std::vector<double>& groups, long long row_count)
+{
+	std::vector<Window> windows;
+	if (row_count == 0)
+		return windows;
+
+	// Rows are in time order, so every window is one run of rows.
+	Window window;
+	window.begin = 0;
+	for (long long row = 1; row <= row_count; ++row)
+	{
+		bool split = row == row_count;
+		if (!split && options.window > 0.0f)
+			split = std::floor(times[row] / options.window) != std::floor(times[row - 1] / options.window);
+		if (!split && !options.group.empty())
+			split = groups[row] != groups[row - 1];
+		if (!split)
+			continue;
+
+		window.end = row;
+		if (!options.group.empty())
+			window.label = options.group + " " + format_number(groups[window.begin], 10);
+		else if (options.window > 0.0f)
+			window.label = format_number(std::floor(times[window.begin] / options.window) * options.window, 12) + " s";
+		else
+			window.label = "all";
+		windows.push_back(window);
+		window.begin = row;
+	}
+
+	return windows;
+}
+
+template <typename Value>
+static void read_column(const StatReader& reader, JobPool& pool, const std::string& name, std::vector<Value>& values)
+{
+	int column = reader.find_column(name);
+	if (column == -1)
+		throw std::runtime_error("There is no column " + name);
+
+	values.resize(static_cast<size_t>(reader.get_row_count()));
+	if (values.empty())
+		return;
+
+	Value* first = &values[0];
+	pool.parallel_for(reader.get_chunk_count(), 1, [&](int begin, int end)
+	{
+		reader.read_column(column, begin, end, first + reader.get_chunk_first_row(begin));
+	});
+}
+
+template <typename Value>
+static void aggregate_windows(const Options& options, const std::vector<Value>& values, const std::vector<Window>& windows, JobPool& pool,
+	std::vector<Summary>& summaries, std::vector<std::vector<double> >& percentiles, std::vector<std::vector<long long> >& bins)
+{
+	pool.parallel_for(static_cast<int>(windows.size()), 1, [&](int begin, int end)
+	{
+		std::vector<Value> finite;
+		for (int w = begin; w < end; ++w)
+		{
+			Summary& summary = summaries[w];
+			summary.count = 0;
+			summary.min = INFINITY;
+			summary.max = -INFINITY;
+			summary.sum = 0.0;
+			summary.above = 0;
+			summary.non_finite = 0;
+
+			// NaNs and infinities would poison the sum and break the ordering nth_element relies on, so they are only counted.
+			finite.clear();
+			for (long long row = windows[w].begin; row < windows[w].end; ++row)
+			{
+				if (std::isfinite(values[row]))
+					finite.push_back(values[row]);
+				else
+					summary.non_finite++;
+			}
+
+			if (!finite.empty())
+			{
+				summarize(&finite[0], static_cast<int>(finite.size()), options.threshold, summary);
+				if (options.histogram_bins > 0)
+				{
+					bins[w].assign(options.histogram_bins, 0);
+					histogram(&finite[0], static_cast<int>(finite.size()), static_cast<Value>(summary.min), static_cast<Value>(summary.max), bins[w]);
+				}
+			}
+			find_percentiles(finite, options.percentiles, percentiles[w]);
+		}
+	});
+}
+
+static void list_columns(const StatReader& reader)
+{
+	for (int i = 0; i < reader.get_column_count(); ++i)
+	{
+		StatType type = reader.get_column_type(i);
+		std::cout << "  " << reader.get_column_name(i) << (type == STAT_INT ? " (int)" : type == STAT_DOUBLE ? " (double)" : " (float)") << std::endl;
+	}
+}
+
+static long long query_file(const Options& options, const std::string& path, JobPool& pool)
+{
+	StatReader reader;
+	reader.open(path);
+	long long row_count = reader.get_row_count();
+
+	std::vector<double> times;
+	if (reader.find_column("time") != -1)
+		read_column(reader, pool, "time", times);
+	else if (options.window > 0.0f || options.has_threshold)
+		throw std::runtime_error("There is no time column for --window and --above");
+
+	double duration = times.size() > 1 ? times.back() - times.front() : 0.0;
+	std::cout << path << ": " << row_count << " rows, " << format_number(duration) << " s" << std::endl;
+	if (options.columns.empty())
+	{
+		list_columns(reader);
+		return row_count;
+	}
+
+	std::vector<double> groups;
+	if (!options.group.empty())
+		read_column(reader, pool, options.group, groups);
+	std::vector<Window> windows = find_windows(options, times, groups, row_count);
+
+	// The time each row stands for, to turn counts into time.
+	double row_time = row_count > 1 ? duration / (row_count - 1) : 0.0;
+
+	// Every field starts with a space, so a value that fills its width still stands apart from the one before.
+	std::cout << std::left << std::setw(16) << "  window" << " " << std::setw(24) << "column" << std::right << " " << std::setw(10) << "rows"
+		<< " " << std::setw(12) << "min" << " " << std::setw(12) << "max" << " " << std::setw(12) << "mean";
+	for (int i = 0; i < options.percentiles.size(); ++i)
+	{
+		std::cout << " " << std::setw(12) << ("p" + format_number(options.percentiles[i]));
+	}
+	if (options.has_threshold)
+		std::cout << " " << std::setw(16) << ("s > " + format_number(options.threshold));
+	std::cout << std::endl;
+
+	// Float columns are aggregated as floats, ints and doubles as doubles so they stay exact.
+	std::vector<float> float_values;
+	std::vector<double> double_values;
+	for (int c = 0; c < options.columns.size(); ++c)
+	{
+		int column = reader.find_column(options.columns[c]);
+		bool is_float = column != -1 && reader.get_column_type(column) == STAT_FLOAT;
+		int precision = is_float ? 6 : 10;
+
+		// Aggregate the windows in parallel, then print them in order.
+		std::vector<Summary> summaries(windows.size());
+		std::vector<std::vector<double> > percentiles(windows.size());
+		std::vector<std::vector<long long> > bins(windows.size());
+		if (is_float)
+		{
+			read_column(reader, pool, options.columns[c], float_values);
+			aggregate_windows(options, float_values, windows, pool, summaries, percentiles, bins);
+		}
+		else
+		{
+			read_column(reader, pool, options.columns[c], double_values);
+			aggregate_windows(options, double_values, windows, pool, summaries, percentiles, bins);
+		}
+
+		for (int w = 0; w < windows.size(); ++w)
+		{
+			const Summary& summary = summaries[w];
+			std::cout << std::left << std::setw(16) << ("  " + windows[w].label) << " " << std::setw(24) << options.columns[c] << std::right << " " << std::setw(10) << summary.count
+				<< " " << std::setw(12) << format_number(summary.min, precision) << " " << std::setw(12) << format_number(summary.max, precision)
+				<< " " << std::setw(12) << format_number(summary.sum / summary.count, precision);
+			for (int i = 0; i < percentiles[w].size(); ++i)
+			{
+				std::cout << " " << std::setw(12) << format_number(percentiles[w][i], precision);
+			}
+			if (options.has_threshold)
+				std::cout << " " << std::setw(16) << format_number(summary.above * row_time);
+			std::cout << std::endl;
+			if (summary.non_finite > 0)
+				std::cout << "    " << summary.non_finite << " NaN or infinite values left out" << std::endl;
+
+			for (int b = 0; b < bins[w].size(); ++b)
+			{
+				double bin_size = (summary.max - summary.min) / bins[w].size();
+				int bar = static_cast<int>(40 * bins[w][b] / summary.count);
+				std::cout << "    " << std::setw(12) << format_number(summary.min + b * bin_size, precision) << " " << std::setw(10) << bins[w][b] << " " << std::string(bar, '#') << std::endl;
+			}
+		}
+	}
+
+	return row_count;
+}
+
+static std::vector<std::string> split(const std::string& text, char separator)
+{
+	std::vector<std::string> parts;
+	std::stringstream ss(text);
+	std::string part;
+	while (std::getline(ss, part, separator))
+	{
+		parts.push_back(part);
+	}
+	return parts;
+}
+
+static void parse_arguments(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (i + 1 < argc && std::strcmp(argv[i], "--column") == 0)
+			options.columns.push_back(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--window") == 0)
+			options.window = static_cast<float>(std::atof(argv[++i]));
+		else if (i + 1 < argc && std::strcmp(argv[i], "--group") == 0)
+			options.group = argv[++i];
+		else if (i + 1 < argc && std::strcmp(argv[i], "--above") == 0)
+		{
+			options.has_threshold = true;
+			options.threshold = static_cast<float>(std::atof(argv[++i]));
+		}
+		else if (i + 1 < argc && std::strcmp(argv[i], "--percentiles") == 0)
+		{
+			std::vector<std::string> parts = split(argv[++i], ',');
+			options.percentiles.clear();
+			for (int k = 0; k < parts.size(); ++k)
+			{
+				options.percentiles.push_back(static_cast<float>(std::atof(parts[k].c_str())));
+			}
+			std::sort(options.percentiles.begin(), options.percentiles.end());
+		}
+		else if (i + 1 < argc && std::strcmp(argv[i], "--histogram") == 0)
+			options.histogram_bins = std::atoi(argv[++i]);
+		else if (i + 1 < argc && std::strcmp(argv[i], "--threads") == 0)
+			options.thread_count = std::atoi(argv[++i]);
+		else if (argv[i][0] == '-')
+			throw std::runtime_error(std::string("Unknown argument: ") + argv[i]);
+		else
+			options.files.push_back(argv[i]);
+	}
+
+	if (options.files.empty())
+		throw std::runtime_error("Usage: car2d_query [--column <name>] [--window <s> | --group <column>] [--above <value>] [--percentiles <list>] [--histogram <bins>] [--threads <count>] <run.c2dstat>...");
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	try
+	{
+		parse_arguments(argc, argv, options);
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	JobPool pool(options.thread_count);
+	Clock::time_point start = Clock::now();
+	long long total_rows = 0;
+	int result = 0;
+	for (int i = 0; i < options.files.size(); ++i)
+	{
+		try
+		{
+			total_rows += query_file(options, options.files[i], pool);
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << "Failed to query " << options.files[i] << ": " << e.what() << std::endl;
+			result = 1;
+		}
+	}
+
+	float seconds = std::chrono::duration<float>(Clock::now() - start).count();
+	std::cout << "Scanned " << total_rows << " rows in " << options.files.size() << " files in " << format_number(seconds * 1000.0f) << " ms on " << pool.get_thread_count() << " threads" << std::endl;
+	return result;
+}
\ No newline at end of file
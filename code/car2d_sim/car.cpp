@@ -0,0 +1,342 @@
+#include "car.hpp"
+#include <cstring>
+#include <glm/gtx/compatibility.hpp>
+
+const float Car::G = 9.82f;
+const float Car::EPSILON = 10e-5f;
+
+CarInput::CarInput()
+	: throttle(false)
+	, reverse(false)
+	, ebrake(false)
+	, steer(0.0f)
+	, gear_up(false)
+	, gear_down(false)
+	, toggle_automatic(false)
+{
+
+}
+
+Car::Car(const YAML::Node& car_config, const YAML::Node& config)
+	: description(car_config, config)
+	, telemetry(nullptr)
+	, orientation(90.0f * DEGREES_TO_RADIANS)
+	, car_angular_velocity(0.0f)
+	, steer_angle(0.0f)
+	, position(0.0f)
+	, velocity(0.0f)
+	, acceleration(0.0f)
+	, facing(std::cos(orientation), std::sin(orientation))
+	, velocity_local(0.0f)
+	, acceleration_local(0.0f)
+	, throttle(false)
+	, reverse(false)
+	, ebrake(false)
+	, gear(1)
+	, automatic(false)
+	, front_slipping(false)
+	, rear_slipping(false)
+{
+	memset(&channels, 0, sizeof(channels));
+}
+
+void Car::update(float dt)
+{
+	update_physics(dt);
+}
+
+void Car::set_telemetry(Telemetry* telemetry)
+{
+	this->telemetry = telemetry;
+	if (telemetry == nullptr)
+		return;
+
+	// Grouped the way the overlay shows them, the NONE channels are separator lines.
+	channels.position = telemetry->register_channel("position", TELEMETRY_FLOAT2, "Position (%.1f, %.1f)");
+	channels.speed_kmh = telemetry->register_channel("speed", TELEMETRY_FLOAT, "Speed: %.1f km/h");
+	channels.speed_ms = telemetry->register_channel("speedms", TELEMETRY_FLOAT, "Speed: %.1f m/s");
+	channels.acceleration = telemetry->register_channel("acceleration", TELEMETRY_FLOAT, "Acceleration Local %.1f m/s^2");
+	telemetry->register_channel("blank1", TELEMETRY_NONE, "");
+	channels.engine_rpm = telemetry->register_channel("rpm", TELEMETRY_INT, "Engine RPM: %d rev/min");
+	channels.gear = telemetry->register_channel("gear", TELEMETRY_INT, "Current gear: %d");
+	channels.automatic = telemetry->register_channel("automatic", TELEMETRY_INT, "Automatic: %d");
+	channels.power = telemetry->register_channel("power", TELEMETRY_FLOAT2, "Power/Max Power: %.1f / %.1f kW");
+	channels.maximum_power_rpm = telemetry->register_channel("poweromega", TELEMETRY_INT, "Maximum power RPM: %d rev/min");
+	telemetry->register_channel("blank2", TELEMETRY_NONE, "");
+	channels.engine_torque = telemetry->register_channel("engine torque", TELEMETRY_FLOAT, "Engine torque: %.1f Nm");
+	channels.drive_torque = telemetry->register_channel("drive torque", TELEMETRY_FLOAT, "Drive torque: %.1f Nm");
+	channels.traction_force = telemetry->register_channel("traction force", TELEMETRY_FLOAT, "Traction force: %.1f N");
+	channels.braking_force = telemetry->register_channel("braking force", TELEMETRY_FLOAT, "Braking force: %.1f N");
+	channels.cornering_force_front = telemetry->register_channel("cornering force front", TELEMETRY_FLOAT, "Cornering force front: %.1f N");
+	channels.cornering_force_rear = telemetry->register_channel("cornering force rear", TELEMETRY_FLOAT, "Cornering force rear: %.1f N");
+	channels.drag_resistance = telemetry->register_channel("drag force", TELEMETRY_FLOAT, "Drag resistance: %.1f N");
+	channels.rolling_resistance = telemetry->register_channel("rolling friction", TELEMETRY_FLOAT, "Rolling resistance: %.1f N");
+	channels.front_total_traction = telemetry->register_channel("total traction front", TELEMETRY_FLOAT, "Total traction front: %.1f N");
+	channels.rear_total_traction = telemetry->register_channel("total traction rear", TELEMETRY_FLOAT, "Total traction rear: %.1f N");
+	channels.front_slipping = telemetry->register_channel("front slipping", TELEMETRY_INT, "Front slipping: %d");
+	channels.rear_slipping = telemetry->register_channel("rear slipping", TELEMETRY_INT, "Rear slipping: %d");
+
+	// Constant for the car, so write it once.
+	telemetry->set(channels.maximum_power_rpm, (int) (description.maximum_power_omega * ANGULAR_VELOCITY_TO_RPM));
+}
+
+void Car::place(const glm::vec2& position, float orientation)
+{
+	this->position = position;
+	this->orientation = orientation;
+	facing = glm::vec2(std::cos(orientation), std::sin(orientation));
+}
+
+void Car::handle_input(const CarInput& input)
+{
+	// Handle throttle/braking
+	throttle = input.throttle;
+	reverse = input.reverse;
+	ebrake = input.ebrake;
+
+	// Handle steering.
+	steer_angle = input.steer * description.max_steer_angle;
+
+	// Handle gearing.
+	if (input.toggle_automatic)
+		automatic = !automatic;
+
+	if (!automatic)
+	{
+		if (input.gear_up)
+		{
+			gear = glm::clamp(gear + 1, 1, 5);
+		}
+
+		if (input.gear_down)
+		{
+			gear = glm::clamp(gear - 1, 1, 5);
+		}
+	}
+}
+
+void Car::update_physics(float dt)
+{
+	float speed = glm::length(velocity_local);
+
+	// Calculate weight distribution.
+	float weight = description.mass * G;
+	float wheelbase = description.cg_to_front_axle + description.cg_to_back_axle;
+	float front_weight = (description.cg_to_back_axle / wheelbase) * weight - (description.cg_height / wheelbase) * description.mass * acceleration_local.x;
+	float rear_weight = (description.cg_to_front_axle / wheelbase) * weight + (description.cg_height / wheelbase) * description.mass * acceleration_local.x;
+	
+	// Assume the wheels are rolling. Only the automatic needs to know the engine speed.
+	float wheel_angular_velocity = velocity_local.x / description.wheel_radius;
+
+	if (automatic)
+	{
+		float engine_rpm = ANGULAR_VELOCITY_TO_RPM * wheel_angular_velocity * description.transmissions[gear];
+		if (engine_rpm >= description.gear_up_rpm)
+		{
+			gear = glm::clamp(gear + 1, 1, 5);
+		}
+
+		if (engine_rpm < description.gear_down_rpm)
+		{
+			gear = glm::clamp(gear - 1, 1, 5);
+		}
+	}
+
+	// Simplified traction model - use the torque on the wheels, which the tables give directly for the gear.
+	// In a more precise implementation, the angular velocity of the wheels should be integrated and 
+	// a slip ratio calculated that can be used as a basis for forward traction. This is a simpler model however.
+	float drive_torque = throttle ? description.torque_tables[gear].lookup(wheel_angular_velocity) : 0.0f;
+	float traction_force = drive_torque / description.wheel_radius;
+
+	// Calculate the braking torque on the wheels.
+	float braking_torque = glm::min(reverse * description.brake_torque + ebrake * description.hand_brake_torque, description.brake_torque);
+	float braking_force = -braking_torque / description.wheel_radius * glm::sign(velocity_local.x);
+
+	// Calculate the lateral slip angles and determine the lateral cornering force.
+	float front_angular_velocity = car_angular_velocity * description.cg_to_front_axle;
+	float rear_angular_velocity = -car_angular_velocity * description.cg_to_back_axle;
+	
+	float slip_angle_front = std::atan2(velocity_local.y + front_angular_velocity, std::abs(velocity_local.x)) - glm::sign(velocity_local.x) * steer_angle;
+	float slip_angle_rear  = std::atan2(velocity_local.y + rear_angular_velocity,  std::abs(velocity_local.x));
+	
+	float cornering_force_front = front_weight * -description.cornering_stiffness * slip_angle_front;
+	float cornering_force_rear = rear_weight * -description.cornering_stiffness * slip_angle_rear;
+
+	// The wheels have a limited maximal traction before they start to slide.
+	float front_traction_circle_radius = front_slipping ? description.wheel_slip_friction : description.wheel_adhesive_limit;
+	float rear_traction_circle_radius = rear_slipping ? description.wheel_slip_friction : description.wheel_adhesive_limit;
+
+	rear_traction_circle_radius *= 1.0f - ebrake * (1.0f - description.lock_grip_factor);
+	
+	glm::vec2 front_total_traction = glm::vec2(0, cornering_force_front * std::cos(steer_angle));
+	glm::vec2 rear_total_traction = glm::vec2(traction_force + braking_force, cornering_force_rear);
+
+	float front_total_traction_length = glm::length(front_total_traction);
+	if (front_total_traction_length / front_weight >= front_traction_circle_radius)
+	{
+		front_total_traction /= front_total_traction_length;
+		front_total_traction *= front_traction_circle_radius * front_weight;
+		front_slipping = true;
+	}
+	else
+	{
+		front_slipping = false;
+	}
+
+	float rear_total_traction_length = glm::length(rear_total_traction);
+	if (rear_total_traction_length / rear_weight >= rear_traction_circle_radius)
+	{
+		rear_total_traction /= rear_total_traction_length;
+		rear_total_traction *= rear_traction_circle_radius * rear_weight;
+		rear_slipping = true;
+	}
+	else
+	{
+		rear_slipping = false;
+	}
+
+	// Calculate the torque on the car body and integrate car yaw rate and orientation.
+	float cornering_torque_front = front_total_traction.y * description.cg_to_front_axle;
+	float cornering_torque_rear = rear_total_traction.y * description.cg_to_back_axle;
+	float car_torque = std::cos(steer_angle) * cornering_torque_front - cornering_torque_rear;
+	
+	float car_angular_acceleration = car_torque / description.inertia;
+	car_angular_velocity += car_angular_acceleration * dt;
+	orientation += car_angular_velocity * dt;
+	facing = glm::vec2(std::cos(orientation), std::sin(orientation));
+
+	// Calculate the wind drag force on the car. Simplification that the area facing the velocity direction is the front.
+	float area = description.height * 2.0f * description.halfwidth;
+	float drag_multiplier = 0.5f * description.air_density * area * description.drag_coefficient;
+	glm::vec2 drag_resistance = -drag_multiplier * speed * velocity_local;
+	
+	// Calculate the rolling friction force on the car.
+	glm::vec2 rolling_resistance = glm::vec2(-description.wheel_rolling_friction * velocity_local.x, 0);
+
+	// Sum the forces on the car's CG and integrate the velocity.
+	glm::vec2 force = rear_total_traction + front_total_traction + drag_resistance + rolling_resistance;
+	
+	acceleration_local = force / description.mass;
+	velocity_local += acceleration_local * dt;
+	
+	// Calculate the acceleration and velocity in world coordinates and integrate world position.
+	float sn = std::sin(orientation);
+	float cs = std::cos(orientation);
+	
+	acceleration.x = cs * acceleration_local.x - sn * acceleration_local.y;
+	acceleration.y = sn * acceleration_local.x + cs * acceleration_local.y;
+	velocity.x = cs * velocity_local.x - sn * velocity_local.y;
+	velocity.y = sn * velocity_local.x + cs * velocity_local.y;
+	
+	position += velocity * dt;
+
+	// Publish the intermediate values for debugging traction and braking. These are plain stores,
+	// the formatting is left to whoever displays them.
+	if (telemetry != nullptr)
+	{
+		float transmission = description.transmissions[gear];
+		float engine_rpm = ANGULAR_VELOCITY_TO_RPM * wheel_angular_velocity * transmission;
+		float engine_torque = transmission != 0.0f ? drive_torque / transmission : 0.0f;
+		float published_speed = glm::length(velocity_local);
+		telemetry->set(channels.position, position.x, position.y);
+		telemetry->set(channels.speed_kmh, published_speed * 3.6f);
+		telemetry->set(channels.speed_ms, published_speed);
+		telemetry->set(channels.acceleration, glm::length(acceleration_local));
+		telemetry->set(channels.engine_rpm, (int) engine_rpm);
+		telemetry->set(channels.gear, gear);
+		telemetry->set(channels.automatic, (int) automatic);
+		telemetry->set(channels.power, engine_torque * engine_rpm * RPM_TO_ANGULAR_VELOCITY / 1000.0f, description.maximum_power / 1000.0f);
+		telemetry->set(channels.engine_torque, engine_torque);
+		telemetry->set(channels.drive_torque, drive_torque);
+		telemetry->set(channels.traction_force, traction_force);
+		telemetry->set(channels.braking_force, braking_force);
+		telemetry->set(channels.cornering_force_front, cornering_force_front);
+		telemetry->set(channels.cornering_force_rear, cornering_force_rear);
+		telemetry->set(channels.drag_resistance, glm::length(drag_resistance));
+		telemetry->set(channels.rolling_resistance, glm::length(rolling_resistance));
+		telemetry->set(channels.front_total_traction, glm::length(front_total_traction));
+		telemetry->set(channels.rear_total_traction, glm::length(rear_total_traction));
+		telemetry->set(channels.front_slipping, (int) front_slipping);
+		telemetry->set(channels.rear_slipping, (int) rear_slipping);
+	}
+}
+
+const CarDescription& Car::get_description() const
+{
+	return description;
+}
+
+const glm::vec2& Car::get_position() const
+{
+	return position;
+}
+
+const glm::vec2& Car::get_facing() const
+{
+	return facing;
+}
+
+const glm::vec2& Car::get_velocity() const
+{
+	return velocity;
+}
+
+const glm::vec2& Car::get_acceleration() const
+{
+	return acceleration;
+}
+
+const glm::vec2& Car::get_velocity_local() const
+{
+	return velocity_local;
+}
+
+const glm::vec2& Car::get_acceleration_local() const
+{
+	return acceleration_local;
+}
+
+float Car::get_orientation() const
+{
+	return orientation;
+}
+
+float Car::get_angular_velocity() const
+{
+	return car_angular_velocity;
+}
+
+float Car::get_steer_angle() const
+{
+	return steer_angle;
+}
+
+int Car::get_gear() const
+{
+	return gear;
+}
+
+bool Car::is_automatic() const
+{
+	return automatic;
+}
+
+bool Car::is_front_slipping() const
+{
+	return front_slipping;
+}
+
+bool Car::is_rear_slipping() const
+{
+	return rear_slipping;
+}
+
+float Car::get_maximum_power() const
+{
+	return description.maximum_power;
+}
+
+float Car::get_maximum_power_omega() const
+{
+	return description.maximum_power_omega;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include <glm/glm.hpp>
+#include "sim_config.hpp"
+#include "car_description.hpp"
+#include "telemetry.hpp"
+
+/*
+	The driver controls for the car. These are sampled once per fixed tick and do not depend
+	on any particular input device.
+*/
+struct CarInput
+{
+	bool throttle;								// Whether the throttle is active or not.
+	bool reverse;								// Whether the reverse/brake is active or not.
+	bool ebrake;								// Whether the parking brake is active or not.
+	float steer;								// The steering input in [-1, 1], positive is left.
+	bool gear_up;								// Shift up one gear (ignored by the automatic).
+	bool gear_down;								// Shift down one gear (ignored by the automatic).
+	bool toggle_automatic;						// Switch between automatic and manual gearing.
+
+	CarInput();
+};
+
+class Car
+{
+public:
+	Car(const YAML::Node& car_config, const YAML::Node& config);
+
+	void handle_input(const CarInput& input);
+	void update(float dt);
+
+	/*
+		Register the car's channels and publish its state into the telemetry after every update.
+		Pass nullptr to stop publishing. The telemetry must outlive the car or be detached first.
+	*/
+	void set_telemetry(Telemetry* telemetry);
+
+	/* Move the car and turn it to the orientation (rad), keeping the rest of its state. */
+	void place(const glm::vec2& position, float orientation);
+
+	const CarDescription& get_description() const;
+	const glm::vec2& get_position() const;
+	const glm::vec2& get_facing() const;
+	const glm::vec2& get_velocity() const;
+	const glm::vec2& get_acceleration() const;
+	const glm::vec2& get_velocity_local() const;
+	const glm::vec2& get_acceleration_local() const;
+	float get_orientation() const;
+	float get_angular_velocity() const;
+	float get_steer_angle() const;
+	int get_gear() const;
+	bool is_automatic() const;
+	bool is_front_slipping() const;
+	bool is_rear_slipping() const;
+	float get_maximum_power() const;
+	float get_maximum_power_omega() const;
+
+	static const float G;
+	static const float EPSILON;
+private:
+	/*
+		The telemetry ids of the values published after each update.
+	*/
+	struct TelemetryChannels
+	{
+		int position;
+		int speed_kmh;
+		int speed_ms;
+		int acceleration;
+		int engine_rpm;
+		int gear;
+		int automatic;
+		int power;
+		int maximum_power_rpm;
+		int engine_torque;
+		int drive_torque;
+		int traction_force;
+		int braking_force;
+		int cornering_force_front;
+		int cornering_force_rear;
+		int drag_resistance;
+		int rolling_resistance;
+		int front_total_traction;
+		int rear_total_traction;
+		int front_slipping;
+		int rear_slipping;
+	};
+
+	CarDescription description;
+	Telemetry* telemetry;
+	TelemetryChannels channels;
+
+	float orientation;							// The orientation of the car relative to world orientation (rad)
+	float car_angular_velocity;					// The current rate of turn for the car (change in yaw) (rad/s)
+	float steer_angle;							// The orientation of the front wheels relative to car orientation (rad)
+	glm::vec2 position;							// The position of the car relative to world origin (m)
+	glm::vec2 velocity;							// The velocity of the car relative to world orientation (m/s)
+	glm::vec2 acceleration;						// The acceleration of the car relative to world orientation (m/s^2)
+	glm::vec2 facing;							// The orientation of the longitudal axis relative to the world orienation (calculated from orientation) (N/A)
+	glm::vec2 velocity_local;					// The velocity of the car relative to car orientation (m/s)
+	glm::vec2 acceleration_local;				// The acceleration of the car relative to car orientation (m/s^2)
+	bool throttle;								// Whether the throttle is active or not.
+	bool reverse;								// Whether the reverse/brake is active or not.
+	bool ebrake;								// Whether the parking brake is active or not.
+	int gear;									// The index of the current gear in interval [0, 5]
+	bool automatic;								// Whether the gearing should be handled automatically or manually.
+	bool front_slipping;						// Whether the front is slipping.
+	bool rear_slipping;							// Whether the rear is slipping.
+
+	void update_physics(float dt);
+};
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "car_batch.hpp"
+#include "simd_math.hpp"
+#include <glm/gtx/compatibility.hpp>
+
+// Define CAR2D_BATCH_EXACT_MATH to evaluate the transcendental functions with the C library. The
+// batch then produces bit-identical results to Car, which is what the equivalence checks want.
+#ifdef CAR2D_BATCH_EXACT_MATH
+#define batch_atan2 simd_atan2_exact
+#define batch_sincos simd_sincos_exact
+#else
+#define batch_atan2 simd_atan2
+#define batch_sincos simd_sincos
+#endif
+
+CarBatch::CarBatch(const CarDescription& description)
+	: description(description)
+	, car_count(0)
+{
+
+}
+
+int CarBatch::add_car(const glm::vec2& position, float orientation)
+{
+	int index = car_count++;
+
+	// Grow all arrays by a full lane group of cars at rest when needed.
+	if (index % LANE_WIDTH == 0)
+	{
+		int size = index + LANE_WIDTH;
+		position_x.resize(size, 0.0f);
+		position_y.resize(size, 0.0f);
+		velocity_x.resize(size, 0.0f);
+		velocity_y.resize(size, 0.0f);
+		acceleration_x.resize(size, 0.0f);
+		acceleration_y.resize(size, 0.0f);
+		velocity_local_x.resize(size, 0.0f);
+		velocity_local_y.resize(size, 0.0f);
+		acceleration_local_x.resize(size, 0.0f);
+		acceleration_local_y.resize(size, 0.0f);
+		this->orientation.resize(size, 0.0f);
+		car_angular_velocity.resize(size, 0.0f);
+		steer_angle.resize(size, 0.0f);
+		throttle.resize(size, 0.0f);
+		reverse.resize(size, 0.0f);
+		ebrake.resize(size, 0.0f);
+		gear.resize(size, 1);
+		automatic.resize(size, 0);
+		front_slipping.resize(size, 0);
+		rear_slipping.resize(size, 0);
+	}
+
+	position_x[index] = position.x;
+	position_y[index] = position.y;
+	this->orientation[index] = orientation;
+
+	return index;
+}
+
+void CarBatch::handle_input(int index, const CarInput& input)
+{
+	throttle[index] = input.throttle ? 1.0f : 0.0f;
+	reverse[index] = input.reverse ? 1.0f : 0.0f;
+	ebrake[index] = input.ebrake ? 1.0f : 0.0f;
+	steer_angle[index] = input.steer * description.max_steer_angle;
+
+	if (input.toggle_automatic)
+		automatic[index] = ~automatic[index];
+
+	if (!automatic[index])
+	{
+		if (input.gear_up)
+			gear[index] = glm::clamp(gear[index] + 1, 1, 5);
+		if (input.gear_down)
+			gear[index] = glm::clamp(gear[index] - 1, 1, 5);
+	}
+}
+
+void CarBatch::update(float dt)
+{
+	update_range(dt, 0, car_count);
+}
+
+void CarBatch::update(float dt, JobPool& job_pool)
+{
+	struct UpdateJob
+	{
+		CarBatch* batch;
+		float dt;
+
+		void operator()(int begin, int end) const
+		{
+			batch->update_range(dt, begin, end);
+		}
+	};
+
+	UpdateJob job = { this, dt };
+	job_pool.parallel_for(car_count, PARALLEL_GRAIN, job);
+}
+
+void CarBatch::update_range(float dt, int begin, int end)
+{
+	for (int first = begin; first < end; first += LANE_WIDTH)
+	{
+		update_lanes(dt, first);
+	}
+}
+
+void CarBatch::update_lanes(float dt, int first)
+{
+	// This mirrors Car::update_physics() step by step, see the comments there.
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 vdt = _mm_set1_ps(dt);
+
+	__m128 vx = _mm_loadu_ps(&velocity_local_x[first]);
+	__m128 vy = _mm_loadu_ps(&velocity_local_y[first]);
+	__m128 ax_local = _mm_loadu_ps(&acceleration_local_x[first]);
+	__m128 angular_velocity = _mm_loadu_ps(&car_angular_velocity[first]);
+	__m128 steer = _mm_loadu_ps(&steer_angle[first]);
+	__m128 vthrottle = _mm_loadu_ps(&throttle[first]);
+	__m128 vreverse = _mm_loadu_ps(&reverse[first]);
+	__m128 vebrake = _mm_loadu_ps(&ebrake[first]);
+
+	__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+
+	// Calculate weight distribution.
+	float weight = description.mass * Car::G;
+	float wheelbase = description.cg_to_front_axle + description.cg_to_back_axle;
+	__m128 transfer = _mm_mul_ps(_mm_set1_ps((description.cg_height / wheelbase) * description.mass), ax_local);
+	__m128 front_weight = _mm_sub_ps(_mm_set1_ps((description.cg_to_back_axle / wheelbase) * weight), transfer);
+	__m128 rear_weight = _mm_add_ps(_mm_set1_ps((description.cg_to_front_axle / wheelbase) * weight), transfer);
+
+	// Assume the wheels are rolling, shift gears for the automatics.
+	__m128 wheel_angular_velocity = _mm_div_ps(vx, _mm_set1_ps(description.wheel_radius));
+
+	int* gears = &gear[first];
+	__m128 vautomatic = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) &automatic[first]));
+	if (_mm_movemask_ps(vautomatic) != 0)
+	{
+		const float* transmissions = &description.transmissions[0];
+		__m128 transmission = _mm_setr_ps(transmissions[gears[0]], transmissions[gears[1]], transmissions[gears[2]], transmissions[gears[3]]);
+		__m128 engine_rpm = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(ANGULAR_VELOCITY_TO_RPM), wheel_angular_velocity), transmission);
+
+		__m128 current_gear = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*) gears));
+		__m128 shift_up = _mm_and_ps(_mm_and_ps(vautomatic, _mm_cmpge_ps(engine_rpm, _mm_set1_ps(description.gear_up_rpm))), one);
+		__m128 shift_down = _mm_and_ps(_mm_and_ps(vautomatic, _mm_cmplt_ps(engine_rpm, _mm_set1_ps(description.gear_down_rpm))), one);
+		current_gear = _mm_min_ps(_mm_max_ps(_mm_add_ps(current_gear, shift_up), one), _mm_set1_ps(5.0f));
+		current_gear = _mm_min_ps(_mm_max_ps(_mm_sub_ps(current_gear, shift_down), one), _mm_set1_ps(5.0f));
+
+		// Only the automatic lanes are written back, the manual ones may legitimately be in reverse.
+		__m128i new_gear = _mm_cvtps_epi32(current_gear);
+		__m128i old_gear = _mm_loadu_si128((const __m128i*) gears);
+		__m128i automatic_mask = _mm_castps_si128(vautomatic);
+		_mm_storeu_si128((__m128i*) gears, _mm_or_si128(_mm_and_si128(automatic_mask, new_gear), _mm_andnot_si128(automatic_mask, old_gear)));
+	}
+
+	// Look up the wheel torque in the baked tables, the same arithmetic as TorqueTable::lookup(). Only
+	// the table parameters and the two samples are fetched per lane, SSE2 has no gathers.
+	const TorqueTable* tables[LANE_WIDTH] = { &description.torque_tables[gears[0]], &description.torque_tables[gears[1]], &description.torque_tables[gears[2]], &description.torque_tables[gears[3]] };
+	__m128 omega_min = _mm_setr_ps(tables[0]->omega_min, tables[1]->omega_min, tables[2]->omega_min, tables[3]->omega_min);
+	__m128 inverse_step = _mm_setr_ps(tables[0]->inverse_step, tables[1]->inverse_step, tables[2]->inverse_step, tables[3]->inverse_step);
+	__m128 last_index = _mm_setr_ps(tables[0]->last_index, tables[1]->last_index, tables[2]->last_index, tables[3]->last_index);
+
+	__m128 u = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(wheel_angular_velocity, omega_min), inverse_step), zero), last_index);
+	__m128i index = _mm_cvttps_epi32(u);
+	__m128 f = _mm_sub_ps(u, _mm_cvtepi32_ps(index));
+
+	int indices[LANE_WIDTH];
+	float t0[LANE_WIDTH];
+	float t1[LANE_WIDTH];
+	_mm_storeu_si128((__m128i*) indices, index);
+	for (int lane = 0; lane < LANE_WIDTH; ++lane)
+	{
+		t0[lane] = tables[lane]->torques[indices[lane]];
+		t1[lane] = tables[lane]->torques[indices[lane] + 1];
+	}
+	__m128 vt0 = _mm_loadu_ps(t0);
+	__m128 wheel_torque = _mm_add_ps(vt0, _mm_mul_ps(f, _mm_sub_ps(_mm_loadu_ps(t1), vt0)));
+
+	// Simplified traction model - use the torque on the wheels.
+	__m128 drive_torque = _mm_and_ps(_mm_cmpneq_ps(vthrottle, zero), wheel_torque);
+	__m128 traction_force = _mm_div_ps(drive_torque, _mm_set1_ps(description.wheel_radius));
+
+	// Calculate the braking torque on the wheels.
+	__m128 braking_torque = _mm_add_ps(_mm_mul_ps(vreverse, _mm_set1_ps(description.brake_torque)), _mm_mul_ps(vebrake, _mm_set1_ps(description.hand_brake_torque)));
+	braking_torque = _mm_min_ps(braking_torque, _mm_set1_ps(description.brake_torque));
+	__m128 sign_vx = simd_sign(vx);
+	__m128 braking_force = _mm_mul_ps(_mm_div_ps(_mm_xor_ps(braking_torque, _mm_set1_ps(-0.0f)), _mm_set1_ps(description.wheel_radius)), sign_vx);
+
+	// Calculate the lateral slip angles and determine the lateral cornering force.
+	__m128 front_angular_velocity = _mm_mul_ps(angular_velocity, _mm_set1_ps(description.cg_to_front_axle));
+	__m128 rear_angular_velocity = _mm_mul_ps(_mm_xor_ps(angular_velocity, _mm_set1_ps(-0.0f)), _mm_set1_ps(description.cg_to_back_axle));
+
+	__m128 abs_vx = simd_abs(vx);
+	__m128 slip_angle_front = _mm_sub_ps(batch_atan2(_mm_add_ps(vy, front_angular_velocity), abs_vx), _mm_mul_ps(sign_vx, steer));
+	__m128 slip_angle_rear = batch_atan2(_mm_add_ps(vy, rear_angular_velocity), abs_vx);
+
+	__m128 negative_stiffness = _mm_set1_ps(-description.cornering_stiffness);
+	__m128 cornering_force_front = _mm_mul_ps(_mm_mul_ps(front_weight, negative_stiffness), slip_angle_front);
+	__m128 cornering_force_rear = _mm_mul_ps(_mm_mul_ps(rear_weight, negative_stiffness), slip_angle_rear);
+
+	// The wheels have a limited maximal traction before they start to slide.
+	__m128 slip_friction = _mm_set1_ps(description.wheel_slip_friction);
+	__m128 adhesive_limit = _mm_set1_ps(description.wheel_adhesive_limit);
+	__m128 was_front_slipping = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) &front_slipping[first]));
+	__m128 was_rear_slipping = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*) &rear_slipping[first]));
+	__m128 front_traction_circle_radius = simd_select(was_front_slipping, slip_friction, adhesive_limit);
+	__m128 rear_traction_circle_radius = simd_select(was_rear_slipping, slip_friction, adhesive_limit);
+	rear_traction_circle_radius = _mm_mul_ps(rear_traction_circle_radius, _mm_sub_ps(one, _mm_mul_ps(vebrake, _mm_set1_ps(1.0f - description.lock_grip_factor))));
+
+	__m128 steer_sin;
+	__m128 steer_cos;
+	batch_sincos(steer, steer_sin, steer_cos);
+
+	__m128 front_total_traction_x = zero;
+	__m128 front_total_traction_y = _mm_mul_ps(cornering_force_front, steer_cos);
+	__m128 rear_total_traction_x = _mm_add_ps(traction_force, braking_force);
+	__m128 rear_total_traction_y = cornering_force_rear;
+
+	__m128 front_total_traction_length = _mm_sqrt_ps(_mm_mul_ps(front_total_traction_y, front_total_traction_y));
+	__m128 front_slip = _mm_cmpge_ps(_mm_div_ps(front_total_traction_length, front_weight), front_traction_circle_radius);
+	__m128 front_scale = _mm_mul_ps(front_traction_circle_radius, front_weight);
+	front_total_traction_y = simd_select(front_slip, _mm_mul_ps(_mm_div_ps(front_total_traction_y, front_total_traction_length), front_scale), front_total_traction_y);
+
+	__m128 rear_total_traction_length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(rear_total_traction_x, rear_total_traction_x), _mm_mul_ps(rear_total_traction_y, rear_total_traction_y)));
+	__m128 rear_slip = _mm_cmpge_ps(_mm_div_ps(rear_total_traction_length, rear_weight), rear_traction_circle_radius);
+	__m128 rear_scale = _mm_mul_ps(rear_traction_circle_radius, rear_weight);
+	rear_total_traction_x = simd_select(rear_slip, _mm_mul_ps(_mm_div_ps(rear_total_traction_x, rear_total_traction_length), rear_scale), rear_total_traction_x);
+	rear_total_traction_y = simd_select(rear_slip, _mm_mul_ps(_mm_div_ps(rear_total_traction_y, rear_total_traction_length), rear_scale), rear_total_traction_y);
+
+	_mm_storeu_si128((__m128i*) &front_slipping[first], _mm_castps_si128(front_slip));
+	_mm_storeu_si128((__m128i*) &rear_slipping[first], _mm_castps_si128(rear_slip));
+
+	// Calculate the torque on the car body and integrate car yaw rate and orientation.
+	__m128 cornering_torque_front = _mm_mul_ps(front_total_traction_y, _mm_set1_ps(description.cg_to_front_axle));
+	__m128 cornering_torque_rear = _mm_mul_ps(rear_total_traction_y, _mm_set1_ps(description.cg_to_back_axle));
+	__m128 car_torque = _mm_sub_ps(_mm_mul_ps(steer_cos, cornering_torque_front), cornering_torque_rear);
+
+	__m128 car_angular_acceleration = _mm_div_ps(car_torque, _mm_set1_ps(description.inertia));
+	angular_velocity = _mm_add_ps(angular_velocity, _mm_mul_ps(car_angular_acceleration, vdt));
+	__m128 vorientation = _mm_add_ps(_mm_loadu_ps(&orientation[first]), _mm_mul_ps(angular_velocity, vdt));
+	_mm_storeu_ps(&car_angular_velocity[first], angular_velocity);
+	_mm_storeu_ps(&orientation[first], vorientation);
+
+	// Calculate the wind drag force on the car.
+	float area = description.height * 2.0f * description.halfwidth;
+	float drag_multiplier = 0.5f * description.air_density * area * description.drag_coefficient;
+	__m128 drag_factor = _mm_mul_ps(_mm_set1_ps(-drag_multiplier), speed);
+	__m128 drag_resistance_x = _mm_mul_ps(drag_factor, vx);
+	__m128 drag_resistance_y = _mm_mul_ps(drag_factor, vy);
+
+	// Calculate the rolling friction force on the car.
+	__m128 rolling_resistance_x = _mm_mul_ps(_mm_set1_ps(-description.wheel_rolling_friction), vx);
+
+	// Sum the forces on the car's CG and integrate the velocity.
+	__m128 force_x = _mm_add_ps(_mm_add_ps(_mm_add_ps(rear_total_traction_x, front_total_traction_x), drag_resistance_x), rolling_resistance_x);
+	__m128 force_y = _mm_add_ps(_mm_add_ps(_mm_add_ps(rear_total_traction_y, front_total_traction_y), drag_resistance_y), zero);
+
+	__m128 mass = _mm_set1_ps(description.mass);
+	__m128 acceleration_local_x_new = _mm_div_ps(force_x, mass);
+	__m128 acceleration_local_y_new = _mm_div_ps(force_y, mass);
+	vx = _mm_add_ps(vx, _mm_mul_ps(acceleration_local_x_new, vdt));
+	vy = _mm_add_ps(vy, _mm_mul_ps(acceleration_local_y_new, vdt));
+	_mm_storeu_ps(&acceleration_local_x[first], acceleration_local_x_new);
+	_mm_storeu_ps(&acceleration_local_y[first], acceleration_local_y_new);
+	_mm_storeu_ps(&velocity_local_x[first], vx);
+	_mm_storeu_ps(&velocity_local_y[first], vy);
+
+	// Calculate the acceleration and velocity in world coordinates and integrate world position.
+	__m128 sn;
+	__m128 cs;
+	batch_sincos(vorientation, sn, cs);
+
+	__m128 world_acceleration_x = _mm_sub_ps(_mm_mul_ps(cs, acceleration_local_x_new), _mm_mul_ps(sn, acceleration_local_y_new));
+	__m128 world_acceleration_y = _mm_add_ps(_mm_mul_ps(sn, acceleration_local_x_new), _mm_mul_ps(cs, acceleration_local_y_new));
+	__m128 world_velocity_x = _mm_sub_ps(_mm_mul_ps(cs, vx), _mm_mul_ps(sn, vy));
+	__m128 world_velocity_y = _mm_add_ps(_mm_mul_ps(sn, vx), _mm_mul_ps(cs, vy));
+	_mm_storeu_ps(&acceleration_x[first], world_acceleration_x);
+	_mm_storeu_ps(&acceleration_y[first], world_acceleration_y);
+	_mm_storeu_ps(&velocity_x[first], world_velocity_x);
+	_mm_storeu_ps(&velocity_y[first], world_velocity_y);
+
+	_mm_storeu_ps(&position_x[first], _mm_add_ps(_mm_loadu_ps(&position_x[first]), _mm_mul_ps(world_velocity_x, vdt)));
+	_mm_storeu_ps(&position_y[first], _mm_add_ps(_mm_loadu_ps(&position_y[first]), _mm_mul_ps(world_velocity_y, vdt)));
+}
+
+int CarBatch::get_car_count() const
+{
+	return car_count;
+}
+
+const CarDescription& CarBatch::get_description() const
+{
+	return description;
+}
+
+glm::vec2 CarBatch::get_position(int index) const
+{
+	return glm::vec2(position_x[index], position_y[index]);
+}
+
+glm::vec2 CarBatch::get_velocity(int index) const
+{
+	return glm::vec2(velocity_x[index], velocity_y[index]);
+}
+
+glm::vec2 CarBatch::get_velocity_local(int index) const
+{
+	return glm::vec2(velocity_local_x[index], velocity_local_y[index]);
+}
+
+float CarBatch::get_orientation(int index) const
+{
+	return orientation[index];
+}
+
+float CarBatch::get_angular_velocity(int index) const
+{
+	return car_angular_velocity[index];
+}
+
+float CarBatch::get_steer_angle(int index) const
+{
+	return steer_angle[index];
+}
+
+int CarBatch::get_gear(int index) const
+{
+	return gear[index];
+}
+
+bool CarBatch::is_automatic(int index) const
+{
+	return automatic[index] != 0;
+}
+
+bool CarBatch::is_front_slipping(int index) const
+{
+	return front_slipping[index] != 0;
+}
+
+bool CarBatch::is_rear_slipping(int index) const
+{
+	return rear_slipping[index] != 0;
+}
\ No newline at end of file
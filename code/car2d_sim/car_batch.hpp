@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "car_description.hpp"
+#include "car.hpp"
+#include "job_pool.hpp"
+
+/*
+	A fleet of cars of the same model, stored as structure-of-arrays and stepped four cars at a time
+	with SSE2. The physics are the same as Car::update_physics(), which is kept as the scalar reference.
+	The arithmetic is done in the same order as in Car, so the only differences come from the vectorized
+	atan2/sin/cos, which are a couple of ulps off the C library. Those can still flip a slip flag near
+	the threshold; build with CAR2D_BATCH_EXACT_MATH for bit-identical results.
+
+	Usage:
+
+	CarBatch batch(description);
+	int index = batch.add_car(glm::vec2(0.0f, 0.0f), 90.0f * DEGREES_TO_RADIANS);
+	batch.handle_input(index, input);
+	batch.update(DT);
+*/
+class CarBatch
+{
+public:
+	static const int LANE_WIDTH = 4;
+	static const int PARALLEL_GRAIN = 256;		// Cars per job, a multiple of LANE_WIDTH.
+
+	CarBatch(const CarDescription& description);
+
+	/* Add a car at rest and return its index. */
+	int add_car(const glm::vec2& position, float orientation);
+
+	/* Apply the driver controls for a single car, same semantics as Car::handle_input. */
+	void handle_input(int index, const CarInput& input);
+
+	/* Step all cars. */
+	void update(float dt);
+
+	/* Step all cars, spread over the threads of the pool. The result does not depend on the thread count. */
+	void update(float dt, JobPool& job_pool);
+
+	/* Step the cars in [begin, end). Both must be multiples of LANE_WIDTH, except end may be get_car_count(). */
+	void update_range(float dt, int begin, int end);
+
+	int get_car_count() const;
+	const CarDescription& get_description() const;
+	glm::vec2 get_position(int index) const;
+	glm::vec2 get_velocity(int index) const;
+	glm::vec2 get_velocity_local(int index) const;
+	float get_orientation(int index) const;
+	float get_angular_velocity(int index) const;
+	float get_steer_angle(int index) const;
+	int get_gear(int index) const;
+	bool is_automatic(int index) const;
+	bool is_front_slipping(int index) const;
+	bool is_rear_slipping(int index) const;
+private:
+	CarDescription description;
+	int car_count;
+
+	// The per car state. The arrays are padded to a multiple of LANE_WIDTH with cars at rest.
+	std::vector<float> position_x;
+	std::vector<float> position_y;
+	std::vector<float> velocity_x;
+	std::vector<float> velocity_y;
+	std::vector<float> acceleration_x;
+	std::vector<float> acceleration_y;
+	std::vector<float> velocity_local_x;
+	std::vector<float> velocity_local_y;
+	std::vector<float> acceleration_local_x;
+	std::vector<float> acceleration_local_y;
+	std::vector<float> orientation;
+	std::vector<float> car_angular_velocity;
+	std::vector<float> steer_angle;
+	std::vector<float> throttle;				// 1.0f when active, 0.0f otherwise.
+	std::vector<float> reverse;					// 1.0f when active, 0.0f otherwise.
+	std::vector<float> ebrake;					// 1.0f when active, 0.0f otherwise.
+	std::vector<int> gear;
+	std::vector<int> automatic;					// -1 (all bits set) when automatic, 0 otherwise.
+	std::vector<int> front_slipping;			// -1 (all bits set) when slipping, 0 otherwise.
+	std::vector<int> rear_slipping;				// -1 (all bits set) when slipping, 0 otherwise.
+
+	void update_lanes(float dt, int first);
+};
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "car_description.hpp"
+#include <cmath>
+
+const float CarDescription::TORQUE_TABLE_MAX_STEP = 25.0f;
+const int CarDescription::TORQUE_TABLE_MAX_SAMPLES = 4096;
+
+static int greatest_common_divisor(int a, int b)
+{
+	while (b != 0)
+	{
+		int r = a % b;
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+CarDescription::CarDescription(const YAML::Node& car_config, const YAML::Node& config)
+{
+	// Read all configuration values.
+	mass = car_config["Mass"].as<float>();
+
+	torque_curve.resize(car_config["TorqueCurve"].size());
+	for (int i = 0; i < car_config["TorqueCurve"].size(); ++i)
+	{
+		torque_curve[i] = glm::vec2(car_config["TorqueCurve"][i][0].as<float>(), car_config["TorqueCurve"][i][1].as<float>());
+	}
+
+	gear_ratios.resize(6);
+	gear_ratios[0] = car_config["GearRatios"]["Reverse"].as<float>();
+	gear_ratios[1] = car_config["GearRatios"]["First"].as<float>();
+	gear_ratios[2] = car_config["GearRatios"]["Second"].as<float>();
+	gear_ratios[3] = car_config["GearRatios"]["Third"].as<float>();
+	gear_ratios[4] = car_config["GearRatios"]["Fourth"].as<float>();
+	gear_ratios[5] = car_config["GearRatios"]["Fifth"].as<float>();
+	differential_ratio = car_config["DifferentialRatio"].as<float>();
+	transmission_efficiency = car_config["TransmissionEfficiency"].as<float>();
+	gear_down_rpm = car_config["GearUpRPM"].as<float>();
+	gear_up_rpm = car_config["GearDownRPM"].as<float>();
+
+	brake_torque = car_config["BrakeTorque"].as<float>();
+	hand_brake_torque = car_config["HandBrakeTorque"].as<float>();
+
+	cg_to_front = car_config["CGToFront"].as<float>();
+	cg_to_back = car_config["CGToBack"].as<float>();
+	cg_height = car_config["CGHeight"].as<float>();
+	height = car_config["Height"].as<float>();
+	halfwidth = car_config["HalfWidth"].as<float>();
+	cg_to_front_axle = car_config["CGToFrontAxle"].as<float>();
+	cg_to_back_axle = car_config["CGToBackAxle"].as<float>();
+	drag_coefficient = car_config["DragCoefficient"].as<float>();
+
+	wheel_mass = car_config["WheelMass"].as<float>();
+	wheel_radius = car_config["WheelRadius"].as<float>();
+	wheel_width = car_config["WheelWidth"].as<float>();
+	wheel_rolling_friction = car_config["WheelRollingFriction"].as<float>();
+	max_steer_angle = car_config["MaxSteerAngle"].as<float>() * DEGREES_TO_RADIANS;
+	cornering_stiffness = car_config["CorneringStiffness"].as<float>();
+	wheel_adhesive_limit = car_config["WheelAdhesiveLimit"].as<float>();
+	wheel_slip_friction = car_config["WheelSlipFriction"].as<float>();
+	lock_grip_factor = car_config["LockGripFactor"].as<float>();
+
+	air_density = config["World"]["AirDensity"].as<float>();
+
+	// Add the wheel mass to the total car mass.
+	mass += 4 * wheel_mass;
+
+	// Calculate the moment of inertia for a cuboid (car body).
+	float length = cg_to_front + cg_to_back;
+	float width = 2.0f * halfwidth;
+	inertia = (1.0f / 12.0f) * mass * (length * length + width * width);
+
+	// Calculate the moment of inertia for a cylinder (wheel).
+	wheel_inertia = 0.5f * wheel_mass * (wheel_radius * wheel_radius);
+
+	// Bake the torque curve into per gear tables, this also finds the maximum power.
+	bake_torque_tables();
+}
+
+void CarDescription::bake_torque_tables()
+{
+	transmissions.resize(gear_ratios.size());
+	for (int i = 0; i < gear_ratios.size(); ++i)
+	{
+		transmissions[i] = gear_ratios[i] * differential_ratio * transmission_efficiency;
+	}
+
+	// Choose the grid. When the curve points are whole rpm apart the grid is lined up with them, which
+	// makes the tables reproduce the piecewise linear curve exactly, up to rounding.
+	float rpm_min = torque_curve.size() > 0 ? torque_curve.front().x : 0.0f;
+	float rpm_range = torque_curve.size() > 1 ? torque_curve.back().x - rpm_min : 0.0f;
+
+	int cells = 1;
+	if (rpm_range > 0.0f)
+	{
+		int common_step = 0;
+		for (int i = 1; i < torque_curve.size() && common_step != -1; ++i)
+		{
+			float offset = torque_curve[i].x - rpm_min;
+			if (offset != std::floor(offset) || offset > 1000000.0f)
+				common_step = -1;
+			else
+				common_step = greatest_common_divisor(common_step, static_cast<int>(offset));
+		}
+
+		if (common_step > 0)
+			cells = static_cast<int>(rpm_range) / common_step * static_cast<int>(std::ceil(common_step / TORQUE_TABLE_MAX_STEP));
+		else
+			cells = static_cast<int>(std::ceil(rpm_range / TORQUE_TABLE_MAX_STEP));
+
+		cells = glm::clamp(cells, 1, TORQUE_TABLE_MAX_SAMPLES - 1);
+	}
+	torque_table_step = rpm_range / cells;
+
+	// Sample the engine torque once, the gears only scale it.
+	std::vector<float> engine_torques(cells + 1);
+	for (int i = 0; i <= cells; ++i)
+	{
+		engine_torques[i] = lerp_curve(torque_curve, rpm_min + rpm_range * i / cells);
+	}
+
+	torque_tables.resize(transmissions.size());
+	for (int gear = 0; gear < transmissions.size(); ++gear)
+	{
+		TorqueTable& table = torque_tables[gear];
+		float rpm_per_omega = ANGULAR_VELOCITY_TO_RPM * transmissions[gear];
+		if (rpm_per_omega == 0.0f || rpm_range == 0.0f)
+		{
+			// The engine speed does not depend on the wheels, so neither does the torque.
+			table.omega_min = 0.0f;
+			table.inverse_step = 0.0f;
+		}
+		else
+		{
+			table.omega_min = rpm_min / rpm_per_omega;
+			table.inverse_step = rpm_per_omega / torque_table_step;
+		}
+		table.last_index = static_cast<float>(cells);
+
+		table.torques.resize(cells + 2);
+		for (int i = 0; i <= cells; ++i)
+		{
+			table.torques[i] = engine_torques[i] * transmissions[gear];
+		}
+		table.torques[cells + 1] = table.torques[cells];
+	}
+
+	// Measure how far the tables are from the curve, at the curve points and inside every cell.
+	torque_table_error = 0.0f;
+	for (int gear = 0; gear < transmissions.size(); ++gear)
+	{
+		float rpm_per_omega = ANGULAR_VELOCITY_TO_RPM * transmissions[gear];
+		if (rpm_per_omega == 0.0f)
+			continue;
+
+		const int SUBSAMPLES = 4;
+		for (int i = 0; i < cells * SUBSAMPLES + static_cast<int>(torque_curve.size()); ++i)
+		{
+			float rpm = i < cells * SUBSAMPLES ? rpm_min + rpm_range * (i + 0.5f) / (cells * SUBSAMPLES) : torque_curve[i - cells * SUBSAMPLES].x;
+			float baked = torque_tables[gear].lookup(rpm / rpm_per_omega) / transmissions[gear];
+			torque_table_error = glm::max(torque_table_error, std::abs(baked - lerp_curve(torque_curve, rpm)));
+		}
+	}
+
+	// Find the maximum power Power = Torque * Angular Velocity. The torque is linear within a cell, so the
+	// maximum is either at a sample or at the stationary point of the quadratic inside a cell.
+	maximum_power = -10000;
+	maximum_power_omega = 0;
+
+	for (int i = 0; i <= cells; ++i)
+	{
+		float omega = (rpm_min + rpm_range * i / cells) * RPM_TO_ANGULAR_VELOCITY;
+		float power = omega * engine_torques[i];
+		if (power > maximum_power)
+		{
+			maximum_power = power;
+			maximum_power_omega = omega;
+		}
+
+		if (i == cells)
+			break;
+
+		float next_omega = (rpm_min + rpm_range * (i + 1) / cells) * RPM_TO_ANGULAR_VELOCITY;
+		float k = (engine_torques[i + 1] - engine_torques[i]) / (next_omega - omega);
+		float stationary_omega = (k * omega - engine_torques[i]) / (2.0f * k);
+		if (stationary_omega > omega && stationary_omega < next_omega)
+		{
+			power = (engine_torques[i] + k * (stationary_omega - omega)) * stationary_omega;
+			if (power > maximum_power)
+			{
+				maximum_power = power;
+				maximum_power_omega = stationary_omega;
+			}
+		}
+	}
+}
+
+float lerp_curve(const std::vector<glm::vec2>& curve, float x)
+{
+	if (curve.size() == 0) return 0.0f;
+
+	float x1 = curve.front().x;
+	float x2 = curve.back().x;
+
+	if (x <= x1) return curve.front().y;
+	if (x >= x2) return curve.back().y;
+
+	int i = 0;
+	for (; i < static_cast<int>(curve.size()); ++i) 
+	{
+		if (curve[i].x > x)
+			break;
+	}
+
+	float dx = curve[i].x - curve[i - 1].x;
+	float dy = curve[i].y - curve[i - 1].y;
+
+	return curve[i - 1].y + ((x - curve[i - 1].x) / dx) * dy;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include <glm/glm.hpp>
+#include "sim_config.hpp"
+
+/*
+	Wheel torque at full throttle as a function of wheel angular velocity for one gear. Sampled on a
+	uniform grid when the car is loaded, so a lookup is a clamp, a truncation and a lerp without any
+	data dependent branches.
+*/
+struct TorqueTable
+{
+	float omega_min;							// The wheel angular velocity at the first sample (rad/s)
+	float inverse_step;							// Samples per unit of wheel angular velocity, negative for negative gear ratios (s/rad)
+	float last_index;							// The index of the last sample, lookups are clamped to it (N/A)
+	std::vector<float> torques;					// The wheel torque at each sample, followed by a copy of the last one (N*m)
+
+	float lookup(float wheel_angular_velocity) const;
+};
+
+/*
+	The static attributes of a car model, read from a car file. Shared by Car and CarBatch.
+*/
+struct CarDescription
+{
+	// Configuration values.
+	float mass;									// The mass of the car (kg)
+	std::vector<glm::vec2> torque_curve;		// The torque curve of the engine (rpm -> N*m)
+
+	float tire_grip;							// The maximum amount of grip of the wheels (N/A)
+
+	std::vector<float> gear_ratios;				// The transmission ratios for the gears (0 is reverse) (N/A)
+	float differential_ratio;					// The transmission ratio for the differential (N/A)
+	float transmission_efficiency;				// The percentage of remaining energy after transmission (N/A)
+	float gear_down_rpm;						// RPM at which the automatic will gear down.
+	float gear_up_rpm;							// RPM at which the automatic will gear up.
+	float brake_torque;							// The torque applied when braking (N*m)
+	float hand_brake_torque;					// The torque applied when locking the tires using the handbrake (N*m)
+	float cg_to_front;							// The distance from center of gravity to front (m)
+	float cg_to_back;							// The distance from center of gravity to back (m)
+	float cg_height;							// The distance from center of gravity to ground (m)
+	float height;								// The from the ground to the top of the car (m)
+	float halfwidth;							// The half width of the car (m)
+	float cg_to_front_axle;						// The distance from center of gravity to front axle (m)
+	float cg_to_back_axle;						// The distance from center of gravity to back axle (m)
+	float drag_coefficient;						// The C_d coefficient in the drag equation (N/A)
+	float wheel_mass;							// The mass of a single wheel (kg)
+	float wheel_radius;							// The radius of the wheels (m)
+	float wheel_width;							// The width of the wheels (m)
+	float wheel_rolling_friction;				// The rolling friction coefficient of the wheels (N/A)
+	float max_steer_angle;						// The maximum angle the wheels can be at relative to the car (rad)
+	float cornering_stiffness;					// The cornering stiffness of the wheels (N/A)
+	float wheel_adhesive_limit;					// The friction limit until the wheels slide (N/A).
+	float wheel_slip_friction;					// The friction when the wheels are sliding (N/A).
+	float lock_grip_factor;						// Multiplied with the amount of grip on the rear wheels when the wheels are locked (N/A)
+
+	float air_density;							// The density of the surrounding air (kg/m^3)
+
+	// Inferred values.
+	float inertia;								// The moment of inertia of the car (kg * m^2)
+	float wheel_inertia;						// The moment of inertia of a single wheel (kg * m^2)
+	float maximum_power_omega;					// The angular velocity of the engine at which the maximum power can be attained (rad/s).
+	float maximum_power;						// The maximum power that can be outputted by the engine (W).
+
+	// Baked values.
+	std::vector<float> transmissions;			// gear_ratio * differential_ratio * transmission_efficiency per gear (N/A)
+	std::vector<TorqueTable> torque_tables;		// The wheel torque per gear, baked from torque_curve (see TorqueTable).
+	float torque_table_step;					// The spacing of the samples in engine speed (rpm)
+	float torque_table_error;					// The largest difference between the tables and torque_curve, in engine torque (N*m)
+
+	static const float TORQUE_TABLE_MAX_STEP;	// The sample spacing the tables are refined to at least (rpm)
+	static const int TORQUE_TABLE_MAX_SAMPLES;	// Upper bound on the samples per gear.
+
+	CarDescription(const YAML::Node& car_config, const YAML::Node& config);
+private:
+	void bake_torque_tables();
+};
+
+inline float TorqueTable::lookup(float wheel_angular_velocity) const
+{
+	float u = glm::min(glm::max((wheel_angular_velocity - omega_min) * inverse_step, 0.0f), last_index);
+	int i = static_cast<int>(u);
+	float f = u - static_cast<float>(i);
+	return torques[i] + f * (torques[i + 1] - torques[i]);
+}
+
+/*
+	Linearly interpolate a curve given as a list of points sorted on x. Values outside the curve are clamped.
+*/
+float lerp_curve(const std::vector<glm::vec2>& curve, float x);
\ No newline at end of file
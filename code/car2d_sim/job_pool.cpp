@@ -0,0 +1,173 @@
+#include "job_pool.hpp"
+#include "profiler.hpp"
+#include <string>
+
+JobPool::JobPool(int thread_count)
+	: pending_jobs(0)
+	, generation(0)
+	, stopping(false)
+{
+	if (thread_count <= 0)
+		thread_count = static_cast<int>(std::thread::hardware_concurrency());
+	if (thread_count <= 0)
+		thread_count = 1;
+
+	// Queue 0 belongs to the thread calling run(), the rest to the workers.
+	for (int i = 0; i < thread_count; ++i)
+	{
+		queues.push_back(new Queue());
+	}
+
+	for (int i = 1; i < thread_count; ++i)
+	{
+		threads.push_back(std::thread(&JobPool::worker_main, this, i));
+	}
+}
+
+JobPool::~JobPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		stopping = true;
+	}
+	wake_condition.notify_all();
+
+	for (int i = 0; i < threads.size(); ++i)
+	{
+		threads[i].join();
+	}
+
+	for (int i = 0; i < queues.size(); ++i)
+	{
+		delete queues[i];
+	}
+}
+
+void JobPool::run(int count, int grain, JobFunction function, void* context)
+{
+	if (count <= 0)
+		return;
+	if (grain <= 0)
+		grain = 1;
+
+	int chunk_count = (count + grain - 1) / grain;
+
+	// Nothing to gain from waking the workers, run the chunks in order on this thread.
+	if (queues.size() == 1 || chunk_count == 1)
+	{
+		for (int begin = 0; begin < count; begin += grain)
+		{
+			function(context, begin, begin + grain < count ? begin + grain : count);
+		}
+		return;
+	}
+
+	// Deal the chunks out round robin so every thread starts with local work.
+	pending_jobs = chunk_count;
+	for (int chunk = 0; chunk < chunk_count; ++chunk)
+	{
+		Job job;
+		job.function = function;
+		job.context = context;
+		job.begin = chunk * grain;
+		job.end = job.begin + grain < count ? job.begin + grain : count;
+
+		Queue& queue = *queues[chunk % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		generation++;
+	}
+	wake_condition.notify_all();
+
+	// Help out until there is nothing left to take, then wait for the chunks still in flight.
+	Job job;
+	while (pop_or_steal(0, job))
+	{
+		execute(job);
+	}
+
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	while (pending_jobs.load() != 0)
+	{
+		done_condition.wait(lock);
+	}
+}
+
+int JobPool::get_thread_count() const
+{
+	return static_cast<int>(queues.size());
+}
+
+void JobPool::worker_main(int index)
+{
+	PROFILE_THREAD("worker " + std::to_string(index));
+	unsigned int seen_generation = 0;
+	while (true)
+	{
+		Job job;
+		if (pop_or_steal(index, job))
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		while (!stopping && generation == seen_generation)
+		{
+			wake_condition.wait(lock);
+		}
+
+		if (stopping)
+			return;
+		seen_generation = generation;
+	}
+}
+
+bool JobPool::pop_or_steal(int index, Job& job)
+{
+	// Newest local work first, it is the most likely to still be in cache.
+	{
+		Queue& queue = *queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest work from the other threads.
+	int queue_count = static_cast<int>(queues.size());
+	for (int i = 1; i < queue_count; ++i)
+	{
+		Queue& queue = *queues[(index + i) % queue_count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobPool::execute(Job& job)
+{
+	{
+		PROFILE_SCOPE("job");
+		job.function(job.context, job.begin, job.end);
+	}
+
+	if (--pending_jobs == 0)
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		done_condition.notify_all();
+	}
+}
\ No newline at end of file
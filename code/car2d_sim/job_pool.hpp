@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+	A fixed set of worker threads with one job deque each. A thread pops jobs from the back of its own
+	deque and, when that runs dry, steals from the front of the others.
+
+	Work is split into chunks whose boundaries depend only on the item count and the grain, never on
+	the number of threads, so as long as the chunks write disjoint data the result is bit-identical for
+	any thread count. The calling thread takes part in the work and parallel_for() returns once every
+	chunk has finished. Only one thread may call it, though not necessarily the one that created it,
+	and jobs may not call it recursively.
+
+	Usage:
+
+	JobPool pool(0);
+	pool.parallel_for(car_count, 256, [&](int begin, int end) { batch.update_range(dt, begin, end); });
+*/
+class JobPool
+{
+public:
+	typedef void (*JobFunction)(void* context, int begin, int end);
+
+	/*
+		Create a pool with the given number of threads, including the calling thread. Zero means one
+		thread per hardware thread.
+	*/
+	JobPool(int thread_count);
+	~JobPool();
+
+	/*
+		Call function(begin, end) for consecutive chunks of at most grain items covering [0, count).
+	*/
+	template <typename Function>
+	void parallel_for(int count, int grain, const Function& function);
+
+	/*
+		Same as above, without the template.
+	*/
+	void run(int count, int grain, JobFunction function, void* context);
+
+	int get_thread_count() const;
+private:
+	struct Job
+	{
+		JobFunction function;
+		void* context;
+		int begin;
+		int end;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<Queue*> queues;
+	std::vector<std::thread> threads;
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	std::condition_variable done_condition;
+	std::atomic<int> pending_jobs;
+	unsigned int generation;
+	bool stopping;
+
+	JobPool(const JobPool&);
+	JobPool& operator=(const JobPool&);
+
+	void worker_main(int index);
+	bool pop_or_steal(int index, Job& job);
+	void execute(Job& job);
+
+	template <typename Function>
+	static void invoke(void* context, int begin, int end);
+};
+
+template <typename Function>
+void JobPool::parallel_for(int count, int grain, const Function& function)
+{
+	run(count, grain, &JobPool::invoke<Function>, const_cast<void*>(static_cast<const void*>(&function)));
+}
+
+template <typename Function>
+void JobPool::invoke(void* context, int begin, int end)
+{
+	(*static_cast<const Function*>(context))(begin, end);
+}
\ No newline at end of file
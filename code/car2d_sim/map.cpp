@@ -0,0 +1,383 @@
+#include "map.hpp"
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+
+/*
+	The layout of a compiled map. Every section starts at a multiple of SECTION_ALIGNMENT bytes from the
+	start of the file and is an array of plain structs in the byte order of the machine that compiled
+	it, so compile maps on the platform that runs them. Strings are stored zero terminated in one
+	section and referred to by their offset in it.
+*/
+struct CompiledMapHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long source_hash;				// FNV-1a of the YAML.
+	unsigned int property_count;
+	unsigned int tile_count;
+	unsigned int segment_count;
+	unsigned int table_size;					// In floats.
+	unsigned int vertex_count;
+	unsigned int index_count;
+	unsigned int strings_offset;
+	unsigned int strings_size;
+	unsigned int properties_offset;				// CompiledMapProperty[property_count]
+	unsigned int tiles_offset;					// CompiledMapTile[tile_count]
+	unsigned int segments_offset;				// RoadSegmentDescription[segment_count]
+	unsigned int table_offsets_offset;			// unsigned int[segment_count]
+	unsigned int tables_offset;					// float[table_size]
+	unsigned int bounds_offset;					// float[4 * segment_count]
+	unsigned int ranges_offset;					// RoadSegmentRange[segment_count]
+	unsigned int vertices_offset;				// RoadVertex[vertex_count]
+	unsigned int indices_offset;				// unsigned int[index_count]
+};
+
+struct CompiledMapProperty
+{
+	unsigned int key;
+	unsigned int value;
+};
+
+struct CompiledMapTile
+{
+	unsigned int file;
+	float bounds[4];
+};
+
+static const char COMPILED_MAGIC[4] = { 'C', '2', 'D', 'M' };
+static const unsigned int SECTION_ALIGNMENT = 16;
+
+const unsigned int Map::COMPILED_VERSION = 1;
+
+static unsigned long long hash_bytes(const unsigned char* data, size_t size)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static bool section_fits(size_t file_size, unsigned int offset, unsigned int count, size_t element_size)
+{
+	return offset <= file_size && count <= (file_size - offset) / element_size;
+}
+
+std::string Map::get_compiled_path(const std::string& path)
+{
+	std::string::size_type extension = path.rfind(".yaml");
+	if (extension != std::string::npos && extension + 5 == path.size())
+		return path.substr(0, extension) + ".c2dmap";
+	return path + ".c2dmap";
+}
+
+Map::Map(const std::string& path)
+	: tiled(false)
+	, compiled(false)
+	, road(nullptr)
+	, mesh(nullptr)
+{
+	MappedFile source;
+	bool have_source = source.open(path);
+	unsigned long long source_hash = have_source ? hash_bytes(source.get_data(), source.get_size()) : 0;
+
+	if (load_compiled(get_compiled_path(path), have_source, source_hash))
+		return;
+
+	if (!have_source)
+		throw std::runtime_error("Failed to open map " + path);
+
+	// Start over from whatever a rejected compiled file left behind.
+	properties = YAML::Node();
+	tiles.clear();
+	tiled = false;
+	load_yaml(YAML::Load(std::string(reinterpret_cast<const char*>(source.get_data()), source.get_size())));
+}
+
+Map::~Map()
+{
+	delete road;
+	delete mesh;
+}
+
+bool Map::load_compiled(const std::string& compiled_path, bool check_hash, unsigned long long source_hash)
+{
+	MappedFile file;
+	if (!file.open(compiled_path))
+		return false;
+
+	const unsigned char* data = file.get_data();
+	size_t size = file.get_size();
+	if (size < sizeof(CompiledMapHeader))
+		return false;
+
+	CompiledMapHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) != 0 || header.version != COMPILED_VERSION)
+		return false;
+	if (check_hash && header.source_hash != source_hash)
+		return false;
+
+	// Refuse a truncated file rather than read past the end of it.
+	if (!section_fits(size, header.strings_offset, header.strings_size, 1) ||
+		!section_fits(size, header.properties_offset, header.property_count, sizeof(CompiledMapProperty)) ||
+		!section_fits(size, header.tiles_offset, header.tile_count, sizeof(CompiledMapTile)) ||
+		!section_fits(size, header.segments_offset, header.segment_count, sizeof(RoadSegmentDescription)) ||
+		!section_fits(size, header.table_offsets_offset, header.segment_count, sizeof(unsigned int)) ||
+		!section_fits(size, header.tables_offset, header.table_size, sizeof(float)) ||
+		!section_fits(size, header.bounds_offset, header.segment_count, 4 * sizeof(float)) ||
+		!section_fits(size, header.ranges_offset, header.segment_count, sizeof(RoadSegmentRange)) ||
+		!section_fits(size, header.vertices_offset, header.vertex_count, sizeof(RoadVertex)) ||
+		!section_fits(size, header.indices_offset, header.index_count, sizeof(unsigned int)))
+		return false;
+	if (header.strings_size > 0 && data[header.strings_offset + header.strings_size - 1] != '\0')
+		return false;
+
+	const char* strings = reinterpret_cast<const char*>(data + header.strings_offset);
+	const CompiledMapProperty* compiled_properties = reinterpret_cast<const CompiledMapProperty*>(data + header.properties_offset);
+	for (unsigned int i = 0; i < header.property_count; ++i)
+	{
+		if (compiled_properties[i].key >= header.strings_size || compiled_properties[i].value >= header.strings_size)
+			return false;
+		properties[std::string(strings + compiled_properties[i].key)] = std::string(strings + compiled_properties[i].value);
+	}
+
+	tiled = header.tile_count > 0;
+	const CompiledMapTile* compiled_tiles = reinterpret_cast<const CompiledMapTile*>(data + header.tiles_offset);
+	tiles.resize(header.tile_count);
+	for (unsigned int i = 0; i < header.tile_count; ++i)
+	{
+		if (compiled_tiles[i].file >= header.strings_size)
+			return false;
+		tiles[i].file = strings + compiled_tiles[i].file;
+		tiles[i].bounds_min = glm::vec2(compiled_tiles[i].bounds[0], compiled_tiles[i].bounds[1]);
+		tiles[i].bounds_max = glm::vec2(compiled_tiles[i].bounds[2], compiled_tiles[i].bounds[3]);
+	}
+
+	if (!tiled)
+	{
+		road = new Road(reinterpret_cast<const RoadSegmentDescription*>(data + header.segments_offset),
+						header.segment_count,
+						reinterpret_cast<const float*>(data + header.tables_offset),
+						reinterpret_cast<const unsigned int*>(data + header.table_offsets_offset),
+						reinterpret_cast<const float*>(data + header.bounds_offset));
+
+		// The mesh stays in the mapped file, which the mesh keeps open until it has been uploaded.
+		mesh = new RoadMesh();
+		mesh->vertices = reinterpret_cast<const RoadVertex*>(data + header.vertices_offset);
+		mesh->indices = reinterpret_cast<const unsigned int*>(data + header.indices_offset);
+		mesh->ranges = reinterpret_cast<const RoadSegmentRange*>(data + header.ranges_offset);
+		mesh->vertex_count = header.vertex_count;
+		mesh->index_count = header.index_count;
+		mesh->segment_count = header.segment_count;
+		mesh->file.swap(file);
+	}
+
+	compiled = true;
+	return true;
+}
+
+void Map::load_yaml(const YAML::Node& map_file)
+{
+	for (YAML::const_iterator it = map_file.begin(); it != map_file.end(); ++it)
+	{
+		if (it->second.IsScalar())
+			properties[it->first.as<std::string>()] = it->second.as<std::string>();
+	}
+
+	if (map_file["Tiles"])
+	{
+		tiled = true;
+		const YAML::Node& tiles_node = map_file["Tiles"];
+		tiles.resize(tiles_node.size());
+		for (int i = 0; i < tiles.size(); ++i)
+		{
+			const YAML::Node& bounds_node = tiles_node[i]["Bounds"];
+			tiles[i].file = tiles_node[i]["File"].as<std::string>();
+			tiles[i].bounds_min = glm::vec2(bounds_node[0].as<float>(), bounds_node[1].as<float>());
+			tiles[i].bounds_max = glm::vec2(bounds_node[2].as<float>(), bounds_node[3].as<float>());
+		}
+		return;
+	}
+
+	road = new Road(map_file);
+	mesh = new RoadMesh();
+	road->tessellate(*mesh);
+}
+
+const YAML::Node& Map::get_properties() const
+{
+	return properties;
+}
+
+bool Map::is_compiled() const
+{
+	return compiled;
+}
+
+bool Map::is_tiled() const
+{
+	return tiled;
+}
+
+const std::vector<MapTile>& Map::get_tiles() const
+{
+	return tiles;
+}
+
+Road* Map::take_road()
+{
+	if (road == nullptr)
+		throw std::runtime_error("The map has no road to take");
+
+	Road* taken = road;
+	road = nullptr;
+	return taken;
+}
+
+RoadMesh* Map::take_mesh()
+{
+	if (mesh == nullptr)
+		throw std::runtime_error("The map has no mesh to take");
+
+	RoadMesh* taken = mesh;
+	mesh = nullptr;
+	return taken;
+}
+
+/* Collects the sections of a compiled map and their offsets. */
+class CompiledMapWriter
+{
+public:
+	std::vector<unsigned char> bytes;
+	std::vector<char> strings;
+
+	CompiledMapWriter()
+		: bytes(sizeof(CompiledMapHeader), 0)
+	{
+
+	}
+
+	unsigned int add_string(const std::string& text)
+	{
+		unsigned int offset = strings.size();
+		strings.insert(strings.end(), text.begin(), text.end());
+		strings.push_back('\0');
+		return offset;
+	}
+
+	unsigned int add_section(const void* data, size_t size)
+	{
+		while (bytes.size() % SECTION_ALIGNMENT != 0)
+		{
+			bytes.push_back(0);
+		}
+
+		unsigned int offset = bytes.size();
+		const unsigned char* first = static_cast<const unsigned char*>(data);
+		bytes.insert(bytes.end(), first, first + size);
+		return offset;
+	}
+
+	template <typename T>
+	unsigned int add_section(const std::vector<T>& elements)
+	{
+		return add_section(elements.empty() ? nullptr : &elements[0], sizeof(T) * elements.size());
+	}
+};
+
+void Map::compile(const std::string& path, const std::string& compiled_path)
+{
+	MappedFile source;
+	if (!source.open(path))
+		throw std::runtime_error("Failed to open map " + path);
+
+	YAML::Node map_file = YAML::Load(std::string(reinterpret_cast<const char*>(source.get_data()), source.get_size()));
+
+	CompiledMapHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+	header.version = COMPILED_VERSION;
+	header.source_hash = hash_bytes(source.get_data(), source.get_size());
+
+	CompiledMapWriter writer;
+
+	std::vector<CompiledMapProperty> compiled_properties;
+	for (YAML::const_iterator it = map_file.begin(); it != map_file.end(); ++it)
+	{
+		if (!it->second.IsScalar())
+			continue;
+
+		CompiledMapProperty property;
+		property.key = writer.add_string(it->first.as<std::string>());
+		property.value = writer.add_string(it->second.as<std::string>());
+		compiled_properties.push_back(property);
+	}
+
+	std::vector<CompiledMapTile> compiled_tiles;
+	std::vector<RoadSegmentDescription> descriptions;
+	std::vector<unsigned int> table_offsets;
+	std::vector<float> tables;
+	std::vector<float> bounds;
+	RoadMesh mesh;
+	if (map_file["Tiles"])
+	{
+		const YAML::Node& tiles_node = map_file["Tiles"];
+		for (int i = 0; i < tiles_node.size(); ++i)
+		{
+			CompiledMapTile tile;
+			tile.file = writer.add_string(tiles_node[i]["File"].as<std::string>());
+			for (int k = 0; k < 4; ++k)
+			{
+				tile.bounds[k] = tiles_node[i]["Bounds"][k].as<float>();
+			}
+			compiled_tiles.push_back(tile);
+		}
+	}
+	else
+	{
+		Road::parse_segments(map_file, descriptions);
+		Road road(descriptions.empty() ? nullptr : &descriptions[0], descriptions.size());
+		for (int i = 0; i < descriptions.size(); ++i)
+		{
+			table_offsets.push_back(tables.size());
+			road.get_segments()[i]->append_tables(tables);
+		}
+
+		const RoadBounds& road_bounds = road.get_bounds();
+		bounds.insert(bounds.end(), road_bounds.min_x.begin(), road_bounds.min_x.end());
+		bounds.insert(bounds.end(), road_bounds.min_y.begin(), road_bounds.min_y.end());
+		bounds.insert(bounds.end(), road_bounds.max_x.begin(), road_bounds.max_x.end());
+		bounds.insert(bounds.end(), road_bounds.max_y.begin(), road_bounds.max_y.end());
+		road.tessellate(mesh);
+	}
+
+	header.property_count = compiled_properties.size();
+	header.tile_count = compiled_tiles.size();
+	header.segment_count = descriptions.size();
+	header.table_size = tables.size();
+	header.vertex_count = mesh.vertex_storage.size();
+	header.index_count = mesh.index_storage.size();
+	header.strings_offset = writer.add_section(writer.strings);
+	header.strings_size = writer.strings.size();
+	header.properties_offset = writer.add_section(compiled_properties);
+	header.tiles_offset = writer.add_section(compiled_tiles);
+	header.segments_offset = writer.add_section(descriptions);
+	header.table_offsets_offset = writer.add_section(table_offsets);
+	header.tables_offset = writer.add_section(tables);
+	header.bounds_offset = writer.add_section(bounds);
+	header.ranges_offset = writer.add_section(mesh.range_storage);
+	header.vertices_offset = writer.add_section(mesh.vertex_storage);
+	header.indices_offset = writer.add_section(mesh.index_storage);
+	memcpy(&writer.bytes[0], &header, sizeof(header));
+
+	std::ofstream out(compiled_path.c_str(), std::ios::binary);
+	if (!out)
+		throw std::runtime_error("Failed to open " + compiled_path + " for writing");
+	out.write(reinterpret_cast<const char*>(&writer.bytes[0]), writer.bytes.size());
+	if (!out)
+		throw std::runtime_error("Failed to write " + compiled_path);
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <yaml-cpp/yaml.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "road.hpp"
+#include "mapped_file.hpp"
+
+/* An entry in the tile list of a tiled map. The file is relative to the directory of the map. */
+struct MapTile
+{
+	std::string file;
+	glm::vec2 bounds_min;
+	glm::vec2 bounds_max;
+};
+
+/*
+	A map, read from its compiled form when there is an up to date one and from the YAML otherwise.
+
+	car2d_mapc compiles maps/test_map.yaml into maps/test_map.c2dmap. The compiled file starts with a
+	version and a hash of the YAML it was made from, and is only used if both match; a map that has
+	been edited since it was compiled is parsed from the YAML as before. When the YAML is missing the
+	compiled file is used as is. The segments, their arc length tables and bounds and the tessellated
+	mesh are all read straight out of the mapped file, with no parsing.
+
+	A map holds either a road or, for tiled maps, a list of tiles that are maps themselves. The top
+	level scalars of the YAML, such as the textures, are kept as properties.
+
+	Usage:
+
+	Map map(DIRECTORY_MAPS + "test_map.yaml");
+	Terrain terrain(map.get_properties());
+	Road* road = map.take_road();
+*/
+class Map
+{
+public:
+	static const unsigned int COMPILED_VERSION;
+
+	/* The path of the compiled file for the YAML at the given path. */
+	static std::string get_compiled_path(const std::string& path);
+
+	/* Compile the YAML at the given path. Tiled maps only have their tile list compiled, not the tiles. */
+	static void compile(const std::string& path, const std::string& compiled_path);
+
+	Map(const std::string& path);
+	~Map();
+
+	/* The top level scalars of the map, as strings. */
+	const YAML::Node& get_properties() const;
+
+	/* Whether the map was read from its compiled file. */
+	bool is_compiled() const;
+
+	bool is_tiled() const;
+	const std::vector<MapTile>& get_tiles() const;
+
+	/* Take the road and its mesh, which the caller then owns. Only for maps that are not tiled. */
+	Road* take_road();
+	RoadMesh* take_mesh();
+private:
+	YAML::Node properties;
+	std::vector<MapTile> tiles;
+	bool tiled;
+	bool compiled;
+	Road* road;
+	RoadMesh* mesh;
+
+	Map(const Map&);
+	Map& operator=(const Map&);
+
+	bool load_compiled(const std::string& compiled_path, bool check_hash, unsigned long long source_hash);
+	void load_yaml(const YAML::Node& map_file);
+};
\ No newline at end of file
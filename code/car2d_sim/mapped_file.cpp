@@ -0,0 +1,143 @@
+#include "mapped_file.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data(nullptr)
+	, size(0)
+#ifdef _WIN32
+	, file_handle(INVALID_HANDLE_VALUE)
+	, mapping_handle(nullptr)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	data = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	size = static_cast<size_t>(file_size.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapping_handle != nullptr)
+		CloseHandle(mapping_handle);
+	if (file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(file_handle);
+
+	data = nullptr;
+	size = 0;
+	mapping_handle = nullptr;
+	file_handle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor == -1)
+		return false;
+
+	struct stat status;
+	if (fstat(descriptor, &status) == -1 || status.st_size == 0)
+	{
+		::close(descriptor);
+		return false;
+	}
+
+	// The mapping keeps the file alive, the descriptor is not needed after this.
+	void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	::close(descriptor);
+	if (mapping == MAP_FAILED)
+		return false;
+
+	data = static_cast<const unsigned char*>(mapping);
+	size = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr)
+		munmap(const_cast<unsigned char*>(data), size);
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
+
+void MappedFile::swap(MappedFile& other)
+{
+	std::swap(data, other.data);
+	std::swap(size, other.size);
+#ifdef _WIN32
+	std::swap(file_handle, other.file_handle);
+	std::swap(mapping_handle, other.mapping_handle);
+#endif
+}
+
+bool MappedFile::is_open() const
+{
+	return data != nullptr;
+}
+
+const unsigned char* MappedFile::get_data() const
+{
+	return data;
+}
+
+size_t MappedFile::get_size() const
+{
+	return size;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+	A read only view of a whole file, mapped into memory. The pages are read in by the OS as they are
+	touched, so opening a large file costs nothing until it is used.
+
+	Usage:
+
+	MappedFile file;
+	if (file.open(path))
+		parse(file.get_data(), file.get_size());
+*/
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/* Map the file, closing any file mapped before. Returns false if the file can not be opened or is empty. */
+	bool open(const std::string& path);
+	void close();
+
+	/* Exchange the mappings of two files, so a mapping can be handed on without reopening it. */
+	void swap(MappedFile& other);
+
+	bool is_open() const;
+	const unsigned char* get_data() const;
+	size_t get_size() const;
+private:
+	const unsigned char* data;
+	size_t size;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "monotonic_clock.hpp"
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+MonotonicClock::time_point MonotonicClock::now()
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	// Split the count so the multiplication can not overflow.
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	long long seconds = counter.QuadPart / frequency.QuadPart;
+	long long remainder = counter.QuadPart % frequency.QuadPart;
+	return time_point(duration(seconds * 1000000000LL + remainder * 1000000000LL / frequency.QuadPart));
+}
+#endif
\ No newline at end of file
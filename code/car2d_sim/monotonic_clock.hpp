@@ -0,0 +1,24 @@
+#pragma once
+
+#include <chrono>
+
+/*
+	A monotonic clock with nanosecond ticks.
+
+	This is std::chrono::steady_clock, except on the compilers from before VS2015 whose steady_clock
+	only advances with the system clock, every millisecond or more. Those read the performance counter.
+*/
+#if defined(_MSC_VER) && _MSC_VER < 1900
+struct MonotonicClock
+{
+	typedef std::chrono::nanoseconds duration;
+	typedef duration::rep rep;
+	typedef duration::period period;
+	typedef std::chrono::time_point<MonotonicClock> time_point;
+	static const bool is_steady = true;
+
+	static time_point now();
+};
+#else
+typedef std::chrono::steady_clock MonotonicClock;
+#endif
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "profiler.hpp"
+#include "monotonic_clock.hpp"
+#include <mutex>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+// VS2013 has no thread_local, but its own keyword works for a plain pointer.
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL thread_local
+#endif
+
+struct ProfileThread
+{
+	static const int EVENT_CAPACITY = 16384;
+
+	std::string name;
+	SpscQueue<ProfileEvent> events;
+	int open_scopes;							// Only touched by the thread itself.
+
+	ProfileThread(const std::string& name)
+		: name(name)
+		, events(EVENT_CAPACITY)
+		, open_scopes(0)
+	{
+
+	}
+};
+
+/* Every thread ever registered. The rings outlive their threads, so no event is lost when one ends. */
+struct ProfileRegistry
+{
+	std::mutex mutex;
+	std::vector<ProfileThread*> threads;
+
+	~ProfileRegistry()
+	{
+		for (int i = 0; i < threads.size(); ++i)
+		{
+			delete threads[i];
+		}
+	}
+};
+
+static ProfileRegistry registry;
+static PROFILE_THREAD_LOCAL ProfileThread* current_thread = nullptr;
+
+void profile_register_thread(const std::string& name)
+{
+	if (current_thread != nullptr)
+		return;
+
+	ProfileThread* thread = new ProfileThread(name);
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.threads.push_back(thread);
+	current_thread = thread;
+}
+
+bool profile_begin(const char* name)
+{
+	ProfileThread* thread = current_thread;
+	if (thread == nullptr)
+		return false;
+
+	// Keep room for the end of this scope and of every scope still open, so no end is ever dropped.
+	if (thread->events.get_free_count() < thread->open_scopes + 2)
+		return false;
+
+	ProfileEvent event;
+	event.name = name;
+	event.time = profile_now();
+	thread->events.push(event);
+	thread->open_scopes++;
+	return true;
+}
+
+void profile_end()
+{
+	ProfileThread* thread = current_thread;
+
+	ProfileEvent event;
+	event.name = nullptr;
+	event.time = profile_now();
+	thread->events.push(event);
+	thread->open_scopes--;
+}
+
+long long profile_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(MonotonicClock::now().time_since_epoch()).count();
+}
+
+const long long Profiler::REPORT_INTERVAL = 500000000;
+const int Profiler::HISTORY_EVENTS = 1 << 17;
+
+Profiler::Profiler()
+	: start_time(profile_now())
+	, report_time(start_time)
+	, report_frame_count(0)
+	, thread_count(0)
+{
+
+}
+
+Profiler::~Profiler()
+{
+
+}
+
+void Profiler::collect()
+{
+	// Give the threads registered since the last call a track each.
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (; thread_count < registry.threads.size(); ++thread_count)
+		{
+			Track track;
+			track.name = registry.threads[thread_count]->name;
+			track.thread = registry.threads[thread_count];
+			tracks.push_back(track);
+		}
+	}
+
+	for (int i = 0; i < tracks.size(); ++i)
+	{
+		if (tracks[i].thread == nullptr)
+			continue;
+
+		ProfileEvent event;
+		while (tracks[i].thread->events.pop(event))
+		{
+			process(i, event);
+		}
+	}
+
+	report_frame_count++;
+	long long now = profile_now();
+	if (now - report_time >= REPORT_INTERVAL)
+		report(now);
+}
+
+int Profiler::add_track(const std::string& name)
+{
+	Track track;
+	track.name = name;
+	track.thread = nullptr;
+	tracks.push_back(track);
+	return static_cast<int>(tracks.size()) - 1;
+}
+
+void Profiler::add_event(int track, const char* name, long long time)
+{
+	ProfileEvent event;
+	event.name = name;
+	event.time = time;
+	process(track, event);
+}
+
+int Profiler::get_line_count() const
+{
+	return static_cast<int>(lines.size());
+}
+
+int Profiler::format_line(int index, char* buffer, int buffer_size) const
+{
+	if (buffer_size <= 0)
+		return 0;
+
+	// The MSVC runtimes we build with predate a conforming snprintf.
+#ifdef _MSC_VER
+#define PROFILER_PRINT(...) _snprintf_s(buffer, buffer_size, _TRUNCATE, __VA_ARGS__)
+#else
+#define PROFILER_PRINT(...) snprintf(buffer, buffer_size, __VA_ARGS__)
+#endif
+	const Line& line = lines[index];
+	int length = 0;
+	if (line.node == -1)
+	{
+		length = PROFILER_PRINT("%s:", tracks[line.track].name.c_str());
+	}
+	else
+	{
+		const Node& node = nodes[line.node];
+		length = PROFILER_PRINT("%*s%s: %.3f ms, %.1f calls", 2 + 2 * node.depth, "", node.name, node.average_time, node.average_calls);
+	}
+#undef PROFILER_PRINT
+
+	if (length < 0 || length >= buffer_size)
+		length = static_cast<int>(strlen(buffer));
+	return length;
+}
+
+void Profiler::write_chrome_trace(const std::string& path) const
+{
+	std::ofstream file(path, std::ios_base::trunc);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file for writing: " + path);
+	}
+
+	// Every track becomes a thread of one process. Matched scopes are written as complete events, the
+	// ends whose beginning fell out of the history are skipped and scopes still open are left out.
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	file.setf(std::ios_base::fixed);
+	file.precision(3);
+	bool first = true;
+	for (int i = 0; i < tracks.size(); ++i)
+	{
+		const Track& track = tracks[i];
+		file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << track.name << "\"}}";
+		file << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"sort_index\":" << i << "}}";
+		first = false;
+
+		std::vector<const ProfileEvent*> open_events;
+		for (int k = 0; k < track.history.size(); ++k)
+		{
+			const ProfileEvent& event = track.history[k];
+			if (event.name != nullptr)
+			{
+				open_events.push_back(&event);
+				continue;
+			}
+			if (open_events.empty())
+				continue;
+
+			const ProfileEvent& begin = *open_events.back();
+			open_events.pop_back();
+			file << ",\n{\"name\":\"" << begin.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i
+				<< ",\"ts\":" << (begin.time - start_time) / 1000.0 << ",\"dur\":" << (event.time - begin.time) / 1000.0 << "}";
+		}
+	}
+	file << "\n]}\n";
+}
+
+void Profiler::process(int track, const ProfileEvent& event)
+{
+	Track& current = tracks[track];
+	current.history.push_back(event);
+	if (current.history.size() > HISTORY_EVENTS)
+		current.history.pop_front();
+
+	if (event.name != nullptr)
+	{
+		OpenScope scope;
+		scope.node = find_node(track, current.open_scopes.empty() ? -1 : current.open_scopes.back().node, event.name);
+		scope.begin_time = event.time;
+		current.open_scopes.push_back(scope);
+	}
+	else if (!current.open_scopes.empty())
+	{
+		Node& node = nodes[current.open_scopes.back().node];
+		node.total_time += event.time - current.open_scopes.back().begin_time;
+		node.calls++;
+		current.open_scopes.pop_back();
+	}
+}
+
+int Profiler::find_node(int track, int parent, const char* name)
+{
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		if (nodes[i].track == track && nodes[i].parent == parent && (nodes[i].name == name || strcmp(nodes[i].name, name) == 0))
+			return i;
+	}
+
+	Node node;
+	node.name = name;
+	node.track = track;
+	node.parent = parent;
+	node.depth = parent == -1 ? 0 : nodes[parent].depth + 1;
+	node.total_time = 0;
+	node.calls = 0;
+	node.average_time = 0.0f;
+	node.average_calls = 0.0f;
+	nodes.push_back(node);
+	return static_cast<int>(nodes.size()) - 1;
+}
+
+void Profiler::report(long long now)
+{
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		Node& node = nodes[i];
+		node.average_time = node.total_time / 1000000.0f / report_frame_count;
+		node.average_calls = static_cast<float>(node.calls) / report_frame_count;
+		node.total_time = 0;
+		node.calls = 0;
+	}
+
+	// List the scopes depth first under their track, in the order they were first seen.
+	lines.clear();
+	for (int i = 0; i < tracks.size(); ++i)
+	{
+		Line line;
+		line.track = i;
+		line.node = -1;
+		lines.push_back(line);
+		add_lines(i, -1);
+
+		// Leave out the tracks with nothing in them yet.
+		if (lines.back().node == -1)
+			lines.pop_back();
+	}
+
+	report_time = now;
+	report_frame_count = 0;
+}
+
+void Profiler::add_lines(int track, int parent)
+{
+	for (int i = 0; i < nodes.size(); ++i)
+	{
+		if (nodes[i].track != track || nodes[i].parent != parent)
+			continue;
+
+		Line line;
+		line.track = track;
+		line.node = i;
+		lines.push_back(line);
+		add_lines(track, i);
+	}
+}
\ No newline at end of file
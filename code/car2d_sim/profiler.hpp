@@ -0,0 +1,165 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include "spsc_queue.hpp"
+
+/*
+	Scoped CPU timers, only compiled in when CAR2D_PROFILE is defined. Without it the macros expand to
+	nothing and no clock is read.
+
+	Every thread that calls PROFILE_THREAD() gets a ring of begin and end events of its own, so timing a
+	scope costs two clock reads and two pushes to a queue no other thread writes. Scopes on threads that
+	never called it are ignored. Names must be string literals, or otherwise outlive the profiler, since
+	only the pointer is stored. A scope that would not fit in the ring, along with the ends of every
+	scope still open, is dropped instead of blocking the thread.
+
+	Usage:
+
+	PROFILE_THREAD("simulation");
+	...
+	{
+		PROFILE_SCOPE("tick");
+		car.update(dt);
+	}
+*/
+#ifdef CAR2D_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_THREAD(name) profile_register_thread(name)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_THREAD(name) ((void) 0)
+#define PROFILE_SCOPE(name) ((void) 0)
+#endif
+
+/* A scope beginning (name set) or ending (name nullptr), in ns of the monotonic clock. */
+struct ProfileEvent
+{
+	const char* name;
+	long long time;
+};
+
+/* Give the calling thread a ring of events, named in the trace. Calling it again does nothing. */
+void profile_register_thread(const std::string& name);
+
+/* Returns false if the scope was not recorded, in which case profile_end() must not be called. */
+bool profile_begin(const char* name);
+void profile_end();
+
+/* The time used for events, in ns of the monotonic clock. */
+long long profile_now();
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name)
+		: recorded(profile_begin(name))
+	{
+
+	}
+
+	~ProfileScope()
+	{
+		if (recorded)
+			profile_end();
+	}
+private:
+	bool recorded;
+
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+};
+
+struct ProfileThread;
+
+/*
+	Collects the events of every profiled thread, along with tracks filled in by hand (e.g. GPU timer
+	queries), and keeps two views of them: the time spent per frame in each scope, averaged over
+	REPORT_INTERVAL and listed as an indented tree for the overlay, and the raw scopes of the last
+	HISTORY_EVENTS events per track, for writing out as a Chrome trace (chrome://tracing or Perfetto).
+
+	Only one thread may use the profiler, normally the one drawing the frames.
+
+	Usage:
+
+	Profiler profiler;
+	each frame:
+		profiler.collect();
+		for (int i = 0; i < profiler.get_line_count(); ++i) profiler.format_line(i, buffer, sizeof(buffer));
+	profiler.write_chrome_trace("profile.json");
+*/
+class Profiler
+{
+public:
+	static const long long REPORT_INTERVAL;
+	static const int HISTORY_EVENTS;
+
+	Profiler();
+	~Profiler();
+
+	/* Take the events from every thread. Call once per frame; the calls also count the frames. */
+	void collect();
+
+	/* Add a track that is filled in with add_event() instead of by a thread. */
+	int add_track(const std::string& name);
+
+	/* Add the next event of the track. Events must be in order and scopes must nest. */
+	void add_event(int track, const char* name, long long time);
+
+	/* The lines of the overlay: each track followed by its scopes. */
+	int get_line_count() const;
+	int format_line(int index, char* buffer, int buffer_size) const;
+
+	/* Write the kept history as Chrome trace event JSON. */
+	void write_chrome_trace(const std::string& path) const;
+private:
+	struct Node
+	{
+		const char* name;
+		int track;
+		int parent;								// -1 for the outermost scopes.
+		int depth;
+		long long total_time;					// Since the last report (ns)
+		int calls;								// Since the last report.
+		float average_time;						// Per frame, at the last report (ms)
+		float average_calls;					// Per frame, at the last report.
+	};
+
+	struct OpenScope
+	{
+		int node;
+		long long begin_time;
+	};
+
+	struct Track
+	{
+		std::string name;
+		ProfileThread* thread;					// nullptr for tracks filled in by hand.
+		std::vector<OpenScope> open_scopes;
+		std::deque<ProfileEvent> history;
+	};
+
+	struct Line
+	{
+		int track;
+		int node;								// -1 for the track name.
+	};
+
+	long long start_time;
+	long long report_time;
+	int report_frame_count;
+	int thread_count;							// The registered threads that have a track.
+	std::vector<Track> tracks;
+	std::vector<Node> nodes;
+	std::vector<Line> lines;
+
+	Profiler(const Profiler&);
+	Profiler& operator=(const Profiler&);
+
+	void process(int track, const ProfileEvent& event);
+	int find_node(int track, int parent, const char* name);
+	void report(long long now);
+	void add_lines(int track, int parent);
+};
\ No newline at end of file
@@ -0,0 +1,617 @@
+#include "road.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include "sim_config.hpp"
+
+// Five point Gauss-Legendre quadrature on [-1, 1], exact for polynomials up to degree nine.
+static const float GAUSS_LEGENDRE_NODES[] = { -0.9061798459386640f, -0.5384693101056831f, 0.0f, 0.5384693101056831f, 0.9061798459386640f };
+static const float GAUSS_LEGENDRE_WEIGHTS[] = { 0.2369268850561891f, 0.4786286704993665f, 0.5688888888888889f, 0.4786286704993665f, 0.2369268850561891f };
+
+const float Road::TESSELLATION_STEP = 1.0f;
+
+Road::Road(const YAML::Node& map_file)
+{
+	std::vector<RoadSegmentDescription> descriptions;
+	parse_segments(map_file, descriptions);
+	create_segments(descriptions.empty() ? nullptr : &descriptions[0], descriptions.size(), nullptr, nullptr, nullptr);
+}
+
+Road::Road(const RoadSegmentDescription* descriptions, int segment_count, const float* tables, const unsigned int* table_offsets, const float* bounds)
+{
+	create_segments(descriptions, segment_count, tables, table_offsets, bounds);
+}
+
+static glm::vec2 parse_point(const YAML::Node& node)
+{
+	return glm::vec2(node[0].as<float>(), node[1].as<float>());
+}
+
+void Road::parse_segments(const YAML::Node& map_file, std::vector<RoadSegmentDescription>& descriptions)
+{
+	const YAML::Node& segments_node = map_file["Segments"];
+	descriptions.resize(segments_node.size());
+	for (int i = 0; i < descriptions.size(); ++i)
+	{
+		const YAML::Node& segment_node = segments_node[i];
+		RoadSegmentDescription& description = descriptions[i];
+		description = RoadSegmentDescription();
+
+		std::string type = segment_node["Type"].as<std::string>();
+		if (type == "Straight")
+		{
+			description.type = ROAD_SEGMENT_STRAIGHT;
+			description.points[0] = parse_point(segment_node["Start"]);
+			description.points[1] = parse_point(segment_node["End"]);
+		}
+		else if (type == "BezierQuadratic")
+		{
+			description.type = ROAD_SEGMENT_BEZIER_QUADRATIC;
+			description.points[0] = parse_point(segment_node["Start"]);
+			description.points[1] = parse_point(segment_node["Control"]);
+			description.points[2] = parse_point(segment_node["End"]);
+		}
+		else if (type == "BezierCubic")
+		{
+			description.type = ROAD_SEGMENT_BEZIER_CUBIC;
+			description.points[0] = parse_point(segment_node["Start"]);
+			description.points[1] = parse_point(segment_node["Control1"]);
+			description.points[2] = parse_point(segment_node["Control2"]);
+			description.points[3] = parse_point(segment_node["End"]);
+		}
+		else if (type == "Clothoid")
+		{
+			description.type = ROAD_SEGMENT_CLOTHOID;
+			description.points[0] = parse_point(segment_node["Start"]);
+			description.heading = segment_node["Heading"].as<float>() * DEGREES_TO_RADIANS;
+			description.length = segment_node["Length"].as<float>();
+			description.start_curvature = segment_node["StartCurvature"].as<float>();
+			description.end_curvature = segment_node["EndCurvature"].as<float>();
+		}
+		else if (type == "Arc")
+		{
+			description.type = ROAD_SEGMENT_ARC;
+			description.points[0] = parse_point(segment_node["Center"]);
+			description.points[1] = parse_point(segment_node["Start"]);
+			description.points[2] = parse_point(segment_node["End"]);
+		}
+		else
+		{
+			throw std::runtime_error("Unknown road segment type: " + type);
+		}
+
+		description.road_width = segment_node["Width"].as<float>();
+		description.texcoord_scale = segment_node["TextureScale"].as<float>();
+	}
+}
+
+void Road::create_segments(const RoadSegmentDescription* descriptions, int segment_count, const float* tables, const unsigned int* table_offsets, const float* bounds_data)
+{
+	segments.resize(segment_count);
+	for (int i = 0; i < segment_count; ++i)
+	{
+		segments[i] = RoadSegment::create(descriptions[i], tables != nullptr ? tables + table_offsets[i] : nullptr);
+	}
+
+	bounds.min_x.resize(segment_count);
+	bounds.min_y.resize(segment_count);
+	bounds.max_x.resize(segment_count);
+	bounds.max_y.resize(segment_count);
+	if (bounds_data != nullptr)
+	{
+		std::copy(bounds_data, bounds_data + segment_count, bounds.min_x.begin());
+		std::copy(bounds_data + segment_count, bounds_data + 2 * segment_count, bounds.min_y.begin());
+		std::copy(bounds_data + 2 * segment_count, bounds_data + 3 * segment_count, bounds.max_x.begin());
+		std::copy(bounds_data + 3 * segment_count, bounds_data + 4 * segment_count, bounds.max_y.begin());
+		return;
+	}
+
+	// Bound the segments.
+	for (int i = 0; i < segment_count; ++i)
+	{
+		glm::vec2 bounds_min;
+		glm::vec2 bounds_max;
+		segments[i]->get_bounds(TESSELLATION_STEP, bounds_min, bounds_max);
+		bounds.min_x[i] = bounds_min.x;
+		bounds.min_y[i] = bounds_min.y;
+		bounds.max_x[i] = bounds_max.x;
+		bounds.max_y[i] = bounds_max.y;
+	}
+}
+
+Road::~Road()
+{
+	for (int i = 0; i < segments.size(); ++i)
+	{
+		delete segments[i];
+	}
+}
+
+const std::vector<RoadSegment*>& Road::get_segments() const
+{
+	return segments;
+}
+
+const RoadBounds& Road::get_bounds() const
+{
+	return bounds;
+}
+
+void Road::tessellate(RoadMesh& mesh) const
+{
+	mesh.range_storage.resize(segments.size());
+	for (int i = 0; i < segments.size(); ++i)
+	{
+		RoadSegmentRange& range = mesh.range_storage[i];
+		range.first_index = mesh.index_storage.size();
+		range.base_vertex = mesh.vertex_storage.size();
+		segments[i]->tessellate(TESSELLATION_STEP, mesh.vertex_storage, mesh.index_storage);
+		range.index_count = mesh.index_storage.size() - range.first_index;
+	}
+	mesh.use_storage();
+}
+
+RoadMesh::RoadMesh()
+	: vertices(nullptr)
+	, indices(nullptr)
+	, ranges(nullptr)
+	, vertex_count(0)
+	, index_count(0)
+	, segment_count(0)
+{
+
+}
+
+void RoadMesh::use_storage()
+{
+	vertices = vertex_storage.empty() ? nullptr : &vertex_storage[0];
+	indices = index_storage.empty() ? nullptr : &index_storage[0];
+	ranges = range_storage.empty() ? nullptr : &range_storage[0];
+	vertex_count = vertex_storage.size();
+	index_count = index_storage.size();
+	segment_count = range_storage.size();
+}
+
+RoadSegment::RoadSegment()
+	: road_width(0.0f)
+	, texcoord_scale(0.0f)
+{
+
+}
+
+RoadSegment::~RoadSegment()
+{
+
+}
+
+RoadSegment* RoadSegment::create(const RoadSegmentDescription& description, const float* tables)
+{
+	RoadSegment* segment = nullptr;
+	const glm::vec2* points = description.points;
+	switch (description.type)
+	{
+		case ROAD_SEGMENT_STRAIGHT: segment = new RoadSegmentStraight(points[0], points[1]); break;
+		case ROAD_SEGMENT_BEZIER_QUADRATIC: segment = new RoadSegmentBezierQuadratic(points[0], points[1], points[2], tables); break;
+		case ROAD_SEGMENT_BEZIER_CUBIC: segment = new RoadSegmentBezierCubic(points[0], points[1], points[2], points[3], tables); break;
+		case ROAD_SEGMENT_CLOTHOID: segment = new RoadSegmentClothoid(points[0], description.heading, description.length, description.start_curvature, description.end_curvature, tables); break;
+		case ROAD_SEGMENT_ARC: segment = new RoadSegmentArc(points[0], points[1], points[2]); break;
+		default: throw std::runtime_error("Unknown road segment type");
+	}
+
+	segment->road_width = description.road_width;
+	segment->texcoord_scale = description.texcoord_scale;
+	return segment;
+}
+
+void RoadSegment::append_tables(std::vector<float>& tables) const
+{
+	tables.insert(tables.end(), arc_lengths.begin(), arc_lengths.end());
+}
+
+float RoadSegment::get_length() const
+{
+	return get_length(1.0f);
+}
+
+const int RoadSegment::ARC_LENGTH_TABLE_INTERVALS = 64;
+const int RoadSegment::ARC_LENGTH_NEWTON_ITERATIONS = 4;
+const float RoadSegment::ARC_LENGTH_TOLERANCE = 1e-6f;
+
+void RoadSegment::build_arc_length_table()
+{
+	arc_lengths.resize(ARC_LENGTH_TABLE_INTERVALS + 1);
+	arc_lengths[0] = 0.0f;
+	for (int i = 0; i < ARC_LENGTH_TABLE_INTERVALS; ++i)
+	{
+		float t1 = static_cast<float>(i) / ARC_LENGTH_TABLE_INTERVALS;
+		float t2 = static_cast<float>(i + 1) / ARC_LENGTH_TABLE_INTERVALS;
+		arc_lengths[i + 1] = arc_lengths[i] + integrate_speed(t1, t2);
+	}
+}
+
+void RoadSegment::load_arc_length_table(const float* tables)
+{
+	arc_lengths.assign(tables, tables + ARC_LENGTH_TABLE_INTERVALS + 1);
+}
+
+float RoadSegment::integrate_speed(float t1, float t2) const
+{
+	float half_width = 0.5f * (t2 - t1);
+	float midpoint = 0.5f * (t1 + t2);
+	float sum = 0.0f;
+	for (int i = 0; i < 5; ++i)
+	{
+		sum += GAUSS_LEGENDRE_WEIGHTS[i] * get_speed(midpoint + half_width * GAUSS_LEGENDRE_NODES[i]);
+	}
+
+	return sum * half_width;
+}
+
+float RoadSegment::get_table_length(float t) const
+{
+	t = glm::clamp(t, 0.0f, 1.0f);
+	int interval = glm::min(static_cast<int>(t * ARC_LENGTH_TABLE_INTERVALS), ARC_LENGTH_TABLE_INTERVALS - 1);
+	return arc_lengths[interval] + integrate_speed(static_cast<float>(interval) / ARC_LENGTH_TABLE_INTERVALS, t);
+}
+
+float RoadSegment::get_table_parameter_at_distance(float distance) const
+{
+	distance = glm::clamp(distance, 0.0f, arc_lengths.back());
+
+	// Find the interval containing the distance.
+	int interval = static_cast<int>(std::upper_bound(arc_lengths.begin(), arc_lengths.end(), distance) - arc_lengths.begin()) - 1;
+	interval = glm::clamp(interval, 0, ARC_LENGTH_TABLE_INTERVALS - 1);
+
+	float t1 = static_cast<float>(interval) / ARC_LENGTH_TABLE_INTERVALS;
+	float t2 = static_cast<float>(interval + 1) / ARC_LENGTH_TABLE_INTERVALS;
+	float interval_length = arc_lengths[interval + 1] - arc_lengths[interval];
+	if (interval_length <= 0.0f)
+		return t1;
+
+	// Start from a linear guess and refine with Newton's method, the derivative of the length is the speed.
+	// Steps that would leave the interval are clamped to it, so the search can not run away.
+	float tolerance = ARC_LENGTH_TOLERANCE * arc_lengths.back();
+	float t = t1 + (t2 - t1) * (distance - arc_lengths[interval]) / interval_length;
+	for (int i = 0; i < ARC_LENGTH_NEWTON_ITERATIONS; ++i)
+	{
+		float error = arc_lengths[interval] + integrate_speed(t1, t) - distance;
+		if (std::abs(error) < tolerance)
+			break;
+
+		float speed = get_speed(t);
+		if (speed <= 0.0f)
+			break;
+
+		t = glm::clamp(t - error / speed, t1, t2);
+	}
+
+	return t;
+}
+
+void RoadSegment::tessellate(float step_length, std::vector<RoadVertex>& vertices, std::vector<unsigned int>& indices) const
+{
+	float length = get_length();
+	int step_count = static_cast<int>(glm::ceil(length / step_length));
+	for (int i = 0; i <= step_count; ++i)
+	{
+		float distance = glm::min(i * step_length, length);
+		float t = get_parameter_at_distance(distance);
+		glm::vec2 position = get_position(t);
+		glm::vec2 normal = get_normal(t);
+		float texcoord = texcoord_scale * i;
+
+		RoadVertex left = { position - normal * road_width, glm::vec2(0.0f, texcoord) };
+		RoadVertex right = { position + normal * road_width, glm::vec2(1.0f, texcoord) };
+		vertices.push_back(left);
+		vertices.push_back(right);
+	}
+
+	// Two triangles per step, vertex 2 * i is the left and 2 * i + 1 the right side of station i.
+	for (unsigned int i = 0; i < static_cast<unsigned int>(step_count); ++i)
+	{
+		unsigned int left1 = 2 * i;
+		unsigned int right1 = 2 * i + 1;
+		unsigned int left2 = 2 * i + 2;
+		unsigned int right2 = 2 * i + 3;
+
+		indices.push_back(left2);
+		indices.push_back(left1);
+		indices.push_back(right1);
+		indices.push_back(left2);
+		indices.push_back(right1);
+		indices.push_back(right2);
+	}
+}
+
+void RoadSegment::get_bounds(float step_length, glm::vec2& bounds_min, glm::vec2& bounds_max) const
+{
+	// Visit the same cross sections as tessellate(), so the box is tight around the mesh.
+	float length = get_length();
+	int step_count = static_cast<int>(glm::ceil(length / step_length));
+	bounds_min = glm::vec2(std::numeric_limits<float>::max());
+	bounds_max = glm::vec2(-std::numeric_limits<float>::max());
+	for (int i = 0; i <= step_count; ++i)
+	{
+		float t = get_parameter_at_distance(glm::min(i * step_length, length));
+		glm::vec2 position = get_position(t);
+		glm::vec2 offset = get_normal(t) * road_width;
+		bounds_min = glm::min(bounds_min, glm::min(position - offset, position + offset));
+		bounds_max = glm::max(bounds_max, glm::max(position - offset, position + offset));
+	}
+}
+
+RoadSegmentStraight::RoadSegmentStraight(const glm::vec2& start, const glm::vec2& end)
+	: start(start)
+	, end(end)
+	, length(glm::length(end - start))
+{
+
+}
+
+glm::vec2 RoadSegmentStraight::get_position(float t) const
+{
+	return start + get_tangent(t) * length * t;
+}
+
+glm::vec2 RoadSegmentStraight::get_normal(float t) const
+{
+	glm::vec2 tangent = get_tangent(t);
+	return glm::vec2(tangent.y, -tangent.x);
+}
+
+glm::vec2 RoadSegmentStraight::get_tangent(float t) const
+{
+	return (end - start) / length;
+}
+
+float RoadSegmentStraight::get_length(float t) const
+{
+	return length * t;
+}
+
+float RoadSegmentStraight::get_parameter_at_distance(float distance) const
+{
+	return distance / length;
+}
+
+float RoadSegmentStraight::get_speed(float t) const
+{
+	return length;
+}
+
+
+RoadSegmentBezierQuadratic::RoadSegmentBezierQuadratic(const glm::vec2& start, const glm::vec2& control, const glm::vec2& end, const float* tables)
+	: start(start)
+	, control(control)
+	, end(end)
+{
+	if (tables != nullptr)
+		load_arc_length_table(tables);
+	else
+		build_arc_length_table();
+}
+
+glm::vec2 RoadSegmentBezierQuadratic::get_position(float t) const
+{
+	float it = 1.0f - t;
+	return it * it * start +
+		   2.0f * it * t * control +
+		   t * t * end;
+}
+
+glm::vec2 RoadSegmentBezierQuadratic::get_normal(float t) const
+{
+	glm::vec2 tangent = get_tangent(t);
+	return glm::vec2(tangent.y, -tangent.x);
+}
+
+glm::vec2 RoadSegmentBezierQuadratic::get_tangent(float t) const
+{
+	return glm::normalize(-2 * (1 - t) * start + 2 * (1 - 2 * t) * control + 2 * t * end);
+}
+
+float RoadSegmentBezierQuadratic::get_length(float t) const
+{
+	return get_table_length(t);
+}
+
+float RoadSegmentBezierQuadratic::get_parameter_at_distance(float distance) const
+{
+	return get_table_parameter_at_distance(distance);
+}
+
+float RoadSegmentBezierQuadratic::get_speed(float t) const
+{
+	return glm::length(2.0f * (1.0f - t) * (control - start) + 2.0f * t * (end - control));
+}
+
+
+RoadSegmentBezierCubic::RoadSegmentBezierCubic(const glm::vec2& start, const glm::vec2& control1, const glm::vec2& control2, const glm::vec2& end, const float* tables)
+	: start(start)
+	, control1(control1)
+	, control2(control2)
+	, end(end)
+{
+	if (tables != nullptr)
+		load_arc_length_table(tables);
+	else
+		build_arc_length_table();
+}
+
+glm::vec2 RoadSegmentBezierCubic::get_position(float t) const
+{
+	float it = 1.0f - t;
+	return it * it * it * start +
+		   3.0f * it * it * t * control1 +
+		   3.0f * it * t * t * control2 +
+		   t * t * t * end;
+}
+
+glm::vec2 RoadSegmentBezierCubic::get_normal(float t) const
+{
+	glm::vec2 tangent = get_tangent(t);
+	return glm::vec2(tangent.y, -tangent.x);
+}
+
+glm::vec2 RoadSegmentBezierCubic::get_tangent(float t) const
+{
+	return glm::normalize(get_derivative(t));
+}
+
+float RoadSegmentBezierCubic::get_length(float t) const
+{
+	return get_table_length(t);
+}
+
+float RoadSegmentBezierCubic::get_parameter_at_distance(float distance) const
+{
+	return get_table_parameter_at_distance(distance);
+}
+
+float RoadSegmentBezierCubic::get_speed(float t) const
+{
+	return glm::length(get_derivative(t));
+}
+
+glm::vec2 RoadSegmentBezierCubic::get_derivative(float t) const
+{
+	float it = 1.0f - t;
+	return 3.0f * it * it * (control1 - start) +
+		   6.0f * it * t * (control2 - control1) +
+		   3.0f * t * t * (end - control2);
+}
+
+
+const int RoadSegmentClothoid::POSITION_TABLE_INTERVALS = 64;
+
+RoadSegmentClothoid::RoadSegmentClothoid(const glm::vec2& start, float heading, float length, float start_curvature, float end_curvature, const float* tables)
+	: heading(heading)
+	, length(length)
+	, start_curvature(start_curvature)
+	, curvature_rate((end_curvature - start_curvature) / length)
+	, positions(POSITION_TABLE_INTERVALS + 1)
+{
+	if (length <= 0.0f)
+		throw std::runtime_error("Clothoid road segment must have a positive length");
+
+	if (tables != nullptr)
+	{
+		for (int i = 0; i <= POSITION_TABLE_INTERVALS; ++i)
+		{
+			positions[i] = glm::vec2(tables[2 * i], tables[2 * i + 1]);
+		}
+		return;
+	}
+
+	positions[0] = start;
+	for (int i = 0; i < POSITION_TABLE_INTERVALS; ++i)
+	{
+		positions[i + 1] = positions[i] + integrate_direction(length * i / POSITION_TABLE_INTERVALS, length * (i + 1) / POSITION_TABLE_INTERVALS);
+	}
+}
+
+void RoadSegmentClothoid::append_tables(std::vector<float>& tables) const
+{
+	for (int i = 0; i <= POSITION_TABLE_INTERVALS; ++i)
+	{
+		tables.push_back(positions[i].x);
+		tables.push_back(positions[i].y);
+	}
+}
+
+glm::vec2 RoadSegmentClothoid::get_position(float t) const
+{
+	t = glm::clamp(t, 0.0f, 1.0f);
+	int interval = glm::min(static_cast<int>(t * POSITION_TABLE_INTERVALS), POSITION_TABLE_INTERVALS - 1);
+	return positions[interval] + integrate_direction(length * interval / POSITION_TABLE_INTERVALS, length * t);
+}
+
+glm::vec2 RoadSegmentClothoid::get_normal(float t) const
+{
+	glm::vec2 tangent = get_tangent(t);
+	return glm::vec2(tangent.y, -tangent.x);
+}
+
+glm::vec2 RoadSegmentClothoid::get_tangent(float t) const
+{
+	float angle = get_heading(length * t);
+	return glm::vec2(std::cos(angle), std::sin(angle));
+}
+
+float RoadSegmentClothoid::get_length(float t) const
+{
+	return length * t;
+}
+
+float RoadSegmentClothoid::get_parameter_at_distance(float distance) const
+{
+	return distance / length;
+}
+
+float RoadSegmentClothoid::get_speed(float t) const
+{
+	return length;
+}
+
+float RoadSegmentClothoid::get_heading(float distance) const
+{
+	return heading + (start_curvature + 0.5f * curvature_rate * distance) * distance;
+}
+
+glm::vec2 RoadSegmentClothoid::integrate_direction(float distance1, float distance2) const
+{
+	float half_width = 0.5f * (distance2 - distance1);
+	float midpoint = 0.5f * (distance1 + distance2);
+	glm::vec2 sum(0.0f);
+	for (int i = 0; i < 5; ++i)
+	{
+		float angle = get_heading(midpoint + half_width * GAUSS_LEGENDRE_NODES[i]);
+		sum += GAUSS_LEGENDRE_WEIGHTS[i] * glm::vec2(std::cos(angle), std::sin(angle));
+	}
+
+	return sum * half_width;
+}
+
+
+RoadSegmentArc::RoadSegmentArc(const glm::vec2& center, const glm::vec2& start, const glm::vec2& end)
+	: center(center)
+	, radius(glm::length(start - center))
+	, start_angle(std::atan2((start - center).y, (start - center).x))
+	, end_angle(std::atan2((end - center).y, (end - center).x))
+	, sign(glm::sign(end_angle - start_angle))
+{
+
+}
+
+glm::vec2 RoadSegmentArc::get_position(float t) const
+{
+	float angle = start_angle + (end_angle - start_angle) * t;
+	return center + radius * glm::vec2(std::cos(angle), std::sin(angle));
+}
+
+glm::vec2 RoadSegmentArc::get_normal(float t) const
+{
+	glm::vec2 tangent = get_tangent(t);
+	return glm::vec2(tangent.y, -tangent.x);
+}
+
+glm::vec2 RoadSegmentArc::get_tangent(float t) const
+{
+	float angle = start_angle + (end_angle - start_angle) * t;
+	return glm::vec2(-std::sin(angle), std::cos(angle)) * sign;
+}
+
+float RoadSegmentArc::get_length(float t) const
+{
+	return (end_angle - start_angle) * t * radius * sign;
+}
+
+float RoadSegmentArc::get_parameter_at_distance(float distance) const
+{
+	return distance / (radius * (end_angle - start_angle)) * sign;
+}
+
+float RoadSegmentArc::get_speed(float t) const
+{
+	return (end_angle - start_angle) * radius * sign;
+}
\ No newline at end of file
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <yaml-cpp/yaml.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "mapped_file.hpp"
+
+class RoadSegment;
+
+enum RoadSegmentType
+{
+	ROAD_SEGMENT_STRAIGHT,
+	ROAD_SEGMENT_BEZIER_QUADRATIC,
+	ROAD_SEGMENT_BEZIER_CUBIC,
+	ROAD_SEGMENT_CLOTHOID,
+	ROAD_SEGMENT_ARC
+};
+
+/*
+	The parameters of a segment as they are written in a map file. Plain data, so compiled maps can
+	store it as is. Which points are used depends on the type:
+
+	Straight: start, end
+	BezierQuadratic: start, control, end
+	BezierCubic: start, control1, control2, end
+	Clothoid: start
+	Arc: center, start, end
+*/
+struct RoadSegmentDescription
+{
+	RoadSegmentType type;
+	glm::vec2 points[4];
+	float heading;								// Clothoid only (rad)
+	float length;								// Clothoid only (m)
+	float start_curvature;						// Clothoid only (1/m)
+	float end_curvature;						// Clothoid only (1/m)
+	float road_width;
+	float texcoord_scale;
+};
+
+/* A vertex of the road mesh. */
+struct RoadVertex
+{
+	glm::vec2 position;
+	glm::vec2 texcoord;
+};
+
+/* Where the mesh of a segment is in the arrays of a RoadMesh. */
+struct RoadSegmentRange
+{
+	unsigned int first_index;
+	unsigned int index_count;
+	int base_vertex;							// The indices of the segment are relative to this vertex.
+};
+
+/*
+	The mesh of a whole road, with one range per segment. The arrays point either into the storage
+	vectors, when the road was tessellated at load time, or into the mapped file of a compiled map,
+	which is then kept open for as long as the mesh lives.
+*/
+struct RoadMesh
+{
+	const RoadVertex* vertices;
+	const unsigned int* indices;
+	const RoadSegmentRange* ranges;
+	int vertex_count;
+	int index_count;
+	int segment_count;
+
+	std::vector<RoadVertex> vertex_storage;
+	std::vector<unsigned int> index_storage;
+	std::vector<RoadSegmentRange> range_storage;
+	MappedFile file;
+
+	RoadMesh();
+
+	/* Point the arrays at the storage vectors. */
+	void use_storage();
+};
+
+/*
+	The axis aligned bounding boxes of the road segments, stored as one array per coordinate so they
+	can be tested without touching the segments themselves.
+*/
+struct RoadBounds
+{
+	std::vector<float> min_x;
+	std::vector<float> min_y;
+	std::vector<float> max_x;
+	std::vector<float> max_y;
+};
+
+/*
+	The road geometry of a map. This only holds the segment curves and their bounds; the GPU buffers
+	are owned by the RoadRenderer in car2d_main.
+*/
+class Road
+{
+public:
+	/* The distance between the cross sections of the road mesh (m). */
+	static const float TESSELLATION_STEP;
+
+	Road(const YAML::Node& map_file);
+
+	/*
+		Create the road from parsed or compiled segments. A compiled map also passes the tables the
+		segments would otherwise build (table_offsets[i] is where those of segment i start, see
+		RoadSegment::append_tables()) and the bounds, as min x, min y, max x and max y arrays one after
+		the other.
+	*/
+	Road(const RoadSegmentDescription* descriptions, int segment_count, const float* tables = nullptr, const unsigned int* table_offsets = nullptr, const float* bounds = nullptr);
+	~Road();
+
+	/* Read the Segments list of a map file. */
+	static void parse_segments(const YAML::Node& map_file, std::vector<RoadSegmentDescription>& descriptions);
+
+	const std::vector<RoadSegment*>& get_segments() const;
+
+	/* The bounds of the tessellated segments, in the same order as get_segments(). */
+	const RoadBounds& get_bounds() const;
+
+	/* Tessellate all segments, in order, into the mesh. Does not touch any GL state, so it may run on any thread. */
+	void tessellate(RoadMesh& mesh) const;
+private:
+	std::vector<RoadSegment*> segments;
+	RoadBounds bounds;
+
+	Road(const Road&);
+	Road& operator=(const Road&);
+
+	void create_segments(const RoadSegmentDescription* descriptions, int segment_count, const float* tables, const unsigned int* table_offsets, const float* bounds);
+};
+
+class RoadSegment
+{
+public:
+	/* The half width of the road and the texture coordinate advance per step. */
+	float road_width;
+	float texcoord_scale;
+
+	RoadSegment();
+	virtual ~RoadSegment();
+
+	/* Create a segment of the described type. The tables may be nullptr, otherwise they must come from append_tables() on the same description. */
+	static RoadSegment* create(const RoadSegmentDescription& description, const float* tables);
+
+	/* Get the position at t-value in [0, 1] */
+	virtual glm::vec2 get_position(float t) const = 0;
+
+	/* Get the right normal at t-value in [0, 1] */
+	virtual glm::vec2 get_normal(float t) const = 0;
+
+	/* Get the tangent at t-value in [0, 1] */
+	virtual glm::vec2 get_tangent(float t) const = 0;
+
+	/* Get the length up to t-value in [0, 1] */
+	virtual float get_length(float t) const = 0;
+
+	/* Get the length of the entire segment. */
+	float get_length() const;
+
+	/* Get t-value at specified distance in [0, get_length()]*/
+	virtual float get_parameter_at_distance(float distance) const = 0;
+
+	/* Get the rate of change of the length at t-value in [0, 1], i.e. the length of the derivative. */
+	virtual float get_speed(float t) const = 0;
+
+	/*
+		Generate the mesh for this segment: a pair of vertices across the road every step_length, joined
+		into an indexed triangle list. Both are appended to the given vectors and the indices are relative
+		to the first vertex appended by this call. The texture coordinate along the road keeps increasing,
+		so the texture should repeat in t.
+	*/
+	void tessellate(float step_length, std::vector<RoadVertex>& vertices, std::vector<unsigned int>& indices) const;
+
+	/* Get the bounds of the mesh tessellate() generates with the same step length. */
+	void get_bounds(float step_length, glm::vec2& bounds_min, glm::vec2& bounds_max) const;
+
+	/* Append the tables the constructor built, so a compiled map can hand them back instead. */
+	virtual void append_tables(std::vector<float>& tables) const;
+protected:
+	/*
+		Curves without a closed form length build a table of the cumulative length at evenly spaced
+		t-values once, in their constructor. A length query is then a table read plus a quadrature over
+		the remaining part of one interval, and a parameter query is a binary search in the table
+		followed by a few Newton steps on that.
+	*/
+	static const int ARC_LENGTH_TABLE_INTERVALS;
+	static const int ARC_LENGTH_NEWTON_ITERATIONS;
+	static const float ARC_LENGTH_TOLERANCE;		// Relative to the segment length.
+
+	std::vector<float> arc_lengths;				// The length up to t = i / ARC_LENGTH_TABLE_INTERVALS (m)
+
+	void build_arc_length_table();
+	void load_arc_length_table(const float* tables);
+	float integrate_speed(float t1, float t2) const;
+	float get_table_length(float t) const;
+	float get_table_parameter_at_distance(float distance) const;
+};
+
+/* A straight line. */
+class RoadSegmentStraight : public RoadSegment
+{
+public:
+	RoadSegmentStraight(const glm::vec2& start, const glm::vec2& end);
+
+	glm::vec2 get_position(float t) const;
+	glm::vec2 get_normal(float t) const;
+	glm::vec2 get_tangent(float t) const;
+	float get_length(float t) const;
+	float get_parameter_at_distance(float distance) const;
+	float get_speed(float t) const;
+private:
+	glm::vec2 start;
+	glm::vec2 end;
+	float length;
+};
+
+/* A quadratic bezier curve. The length is looked up in an arc length table. */
+class RoadSegmentBezierQuadratic : public RoadSegment
+{
+public:
+	RoadSegmentBezierQuadratic(const glm::vec2& start, const glm::vec2& control, const glm::vec2& end, const float* tables = nullptr);
+
+	glm::vec2 get_position(float t) const;
+	glm::vec2 get_normal(float t) const;
+	glm::vec2 get_tangent(float t) const;
+	float get_length(float t) const;
+	float get_parameter_at_distance(float distance) const;
+	float get_speed(float t) const;
+private:
+	glm::vec2 start;
+	glm::vec2 control;
+	glm::vec2 end;
+};
+
+/* A cubic bezier curve. The length is looked up in an arc length table. */
+class RoadSegmentBezierCubic : public RoadSegment
+{
+public:
+	RoadSegmentBezierCubic(const glm::vec2& start, const glm::vec2& control1, const glm::vec2& control2, const glm::vec2& end, const float* tables = nullptr);
+
+	glm::vec2 get_position(float t) const;
+	glm::vec2 get_normal(float t) const;
+	glm::vec2 get_tangent(float t) const;
+	float get_length(float t) const;
+	float get_parameter_at_distance(float distance) const;
+	float get_speed(float t) const;
+private:
+	glm::vec2 start;
+	glm::vec2 control1;
+	glm::vec2 control2;
+	glm::vec2 end;
+
+	glm::vec2 get_derivative(float t) const;
+};
+
+/*
+	A clothoid (Euler spiral), a curve whose curvature changes linearly with the distance along it. Used
+	for easing from a straight into a turn or between turns of different radius.
+
+	The curve is parameterized by arc length, so the length is exact. The position has no closed form
+	(the Fresnel integrals), so the positions at evenly spaced t-values are integrated once in the
+	constructor and a query only integrates the rest of one interval.
+*/
+class RoadSegmentClothoid : public RoadSegment
+{
+public:
+	static const int POSITION_TABLE_INTERVALS;
+
+	/* The heading is the angle of the tangent at the start, counter clockwise from the x-axis. Positive curvature turns left. */
+	RoadSegmentClothoid(const glm::vec2& start, float heading, float length, float start_curvature, float end_curvature, const float* tables = nullptr);
+
+	glm::vec2 get_position(float t) const;
+	glm::vec2 get_normal(float t) const;
+	glm::vec2 get_tangent(float t) const;
+	float get_length(float t) const;
+	float get_parameter_at_distance(float distance) const;
+	float get_speed(float t) const;
+	void append_tables(std::vector<float>& tables) const;
+private:
+	float heading;								// The heading at the start (rad)
+	float length;								// (m)
+	float start_curvature;						// (1/m)
+	float curvature_rate;						// The change in curvature per distance (1/m^2)
+	std::vector<glm::vec2> positions;			// The position at t = i / POSITION_TABLE_INTERVALS.
+
+	float get_heading(float distance) const;
+	glm::vec2 integrate_direction(float distance1, float distance2) const;
+};
+
+/* A circle arc. */
+class RoadSegmentArc : public RoadSegment
+{
+public:
+	/* 
+		The center is constrained by the line which passes through the midpoint of the line segment between
+		the start and end points and which is perpendicular to this line segment. The radius of the circle is
+		hence the distance from center to both start and end.
+	*/
+	RoadSegmentArc(const glm::vec2& center, const glm::vec2& start, const glm::vec2& end);
+
+	glm::vec2 get_position(float t) const;
+	glm::vec2 get_normal(float t) const;
+	glm::vec2 get_tangent(float t) const;
+	float get_length(float t) const;
+	float get_parameter_at_distance(float distance) const;
+	float get_speed(float t) const;
+private:
+	glm::vec2 center;
+	float radius;
+	float start_angle;
+	float end_angle;
+	float sign;
+};
\ No newline at end of file
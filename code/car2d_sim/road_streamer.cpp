@@ -0,0 +1,277 @@
+#include "road_streamer.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+
+const int RoadStreamer::MAX_ARRIVALS_PER_UPDATE = 4;
+
+RoadStreamer::RoadStreamer(Map& map, const std::string& directory, int tile_budget, float preload_distance)
+	: directory(directory)
+	, tile_budget(tile_budget)
+	, preload_distance(preload_distance)
+	, update_count(0)
+	, loading_tile_count(0)
+	, stopping(false)
+{
+	if (map.is_tiled())
+	{
+		const std::vector<MapTile>& map_tiles = map.get_tiles();
+		tiles.resize(map_tiles.size());
+		for (int i = 0; i < tiles.size(); ++i)
+		{
+			tiles[i].file = map_tiles[i].file;
+			tiles[i].bounds_min = map_tiles[i].bounds_min;
+			tiles[i].bounds_max = map_tiles[i].bounds_max;
+		}
+	}
+	else
+	{
+		// Take the whole map as one tile and pass it on as if the loader had finished it.
+		Tile tile;
+		tile.bounds_min = glm::vec2(-std::numeric_limits<float>::max());
+		tile.bounds_max = glm::vec2(std::numeric_limits<float>::max());
+		tiles.push_back(tile);
+
+		LoadedTile loaded;
+		loaded.tile = 0;
+		loaded.road = map.take_road();
+		loaded.mesh = map.take_mesh();
+		loaded_tiles.push_back(loaded);
+	}
+
+	for (int i = 0; i < tiles.size(); ++i)
+	{
+		tiles[i].state = TILE_UNLOADED;
+		tiles[i].last_wanted = 0;
+		tiles[i].road = nullptr;
+		tiles[i].mesh = nullptr;
+	}
+
+	if (!loaded_tiles.empty())
+	{
+		tiles[0].state = TILE_LOADING;
+		loading_tile_count = 1;
+	}
+
+	loader = std::thread(&RoadStreamer::loader_main, this);
+}
+
+RoadStreamer::~RoadStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake_condition.notify_all();
+	loader.join();
+
+	for (int i = 0; i < loaded_tiles.size(); ++i)
+	{
+		delete loaded_tiles[i].road;
+		delete loaded_tiles[i].mesh;
+	}
+
+	for (int i = 0; i < tiles.size(); ++i)
+	{
+		delete tiles[i].road;
+		delete tiles[i].mesh;
+	}
+}
+
+void RoadStreamer::update(const glm::vec2& region_min, const glm::vec2& region_max)
+{
+	update_count++;
+
+	// The meshes of the last arrivals have been uploaded by now.
+	for (int i = 0; i < arrived_tiles.size(); ++i)
+	{
+		Tile& tile = tiles[arrived_tiles[i]];
+		delete tile.mesh;
+		tile.mesh = nullptr;
+	}
+	arrived_tiles.clear();
+	evicted_tiles.clear();
+
+	glm::vec2 wanted_min = region_min - glm::vec2(preload_distance);
+	glm::vec2 wanted_max = region_max + glm::vec2(preload_distance);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!loader_error.empty())
+			throw std::runtime_error(loader_error);
+
+		// Mark the tiles in the region, and queue the ones that are missing.
+		bool requested = false;
+		for (int i = 0; i < tiles.size(); ++i)
+		{
+			Tile& tile = tiles[i];
+			if (tile.bounds_max.x < wanted_min.x || tile.bounds_min.x > wanted_max.x || tile.bounds_max.y < wanted_min.y || tile.bounds_min.y > wanted_max.y)
+				continue;
+
+			tile.last_wanted = update_count;
+			if (tile.state == TILE_UNLOADED)
+			{
+				tile.state = TILE_QUEUED;
+				requests.push_back(i);
+				loading_tile_count++;
+				requested = true;
+			}
+		}
+
+		// Drop the requests that have left the region before the loader got to them.
+		for (std::deque<int>::iterator it = requests.begin(); it != requests.end();)
+		{
+			if (tiles[*it].last_wanted != update_count)
+			{
+				tiles[*it].state = TILE_UNLOADED;
+				loading_tile_count--;
+				it = requests.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (requested)
+			wake_condition.notify_one();
+
+		// Take in a few of the finished tiles.
+		while (!loaded_tiles.empty() && arrived_tiles.size() < MAX_ARRIVALS_PER_UPDATE)
+		{
+			const LoadedTile& loaded = loaded_tiles.front();
+			Tile& tile = tiles[loaded.tile];
+			tile.state = TILE_RESIDENT;
+			tile.road = loaded.road;
+			tile.mesh = loaded.mesh;
+			resident_tiles.push_back(loaded.tile);
+			arrived_tiles.push_back(loaded.tile);
+			loading_tile_count--;
+			loaded_tiles.pop_front();
+		}
+	}
+
+	// Evict the least recently wanted tiles until the budget is met, but never the ones in the region.
+	while (resident_tiles.size() > tile_budget)
+	{
+		int victim = -1;
+		for (int i = 0; i < resident_tiles.size(); ++i)
+		{
+			const Tile& tile = tiles[resident_tiles[i]];
+			if (tile.last_wanted != update_count && (victim == -1 || tile.last_wanted < tiles[resident_tiles[victim]].last_wanted))
+				victim = i;
+		}
+
+		if (victim == -1)
+			break;
+
+		evict(resident_tiles[victim]);
+		resident_tiles[victim] = resident_tiles.back();
+		resident_tiles.pop_back();
+	}
+}
+
+void RoadStreamer::evict(int index)
+{
+	Tile& tile = tiles[index];
+	delete tile.road;
+	delete tile.mesh;
+	tile.road = nullptr;
+	tile.mesh = nullptr;
+	tile.state = TILE_UNLOADED;
+
+	// A tile that arrives and is evicted in the same update was never seen by anyone.
+	std::vector<int>::iterator arrived = std::find(arrived_tiles.begin(), arrived_tiles.end(), index);
+	if (arrived != arrived_tiles.end())
+		arrived_tiles.erase(arrived);
+	else
+		evicted_tiles.push_back(index);
+}
+
+const std::vector<int>& RoadStreamer::get_arrived_tiles() const
+{
+	return arrived_tiles;
+}
+
+const std::vector<int>& RoadStreamer::get_evicted_tiles() const
+{
+	return evicted_tiles;
+}
+
+const Road* RoadStreamer::get_road(int tile) const
+{
+	return tiles[tile].road;
+}
+
+const RoadMesh& RoadStreamer::get_mesh(int tile) const
+{
+	return *tiles[tile].mesh;
+}
+
+void RoadStreamer::get_tile_bounds(int tile, glm::vec2& bounds_min, glm::vec2& bounds_max) const
+{
+	bounds_min = tiles[tile].bounds_min;
+	bounds_max = tiles[tile].bounds_max;
+}
+
+int RoadStreamer::get_tile_count() const
+{
+	return static_cast<int>(tiles.size());
+}
+
+int RoadStreamer::get_resident_tile_count() const
+{
+	return static_cast<int>(resident_tiles.size());
+}
+
+int RoadStreamer::get_loading_tile_count() const
+{
+	return loading_tile_count;
+}
+
+void RoadStreamer::loader_main()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake_condition.wait(lock, [this] { return stopping || !requests.empty(); });
+		if (stopping)
+			return;
+
+		int index = requests.front();
+		requests.pop_front();
+		tiles[index].state = TILE_LOADING;
+		std::string path = directory + tiles[index].file;
+
+		// Load without holding the lock, the main thread only waits for it to hand over tiles.
+		lock.unlock();
+
+		LoadedTile loaded;
+		loaded.tile = index;
+		loaded.road = nullptr;
+		loaded.mesh = nullptr;
+		std::string error;
+		try
+		{
+			Map tile_map(path);
+			loaded.road = tile_map.take_road();
+			loaded.mesh = tile_map.take_mesh();
+		}
+		catch (std::exception& e)
+		{
+			delete loaded.road;
+			delete loaded.mesh;
+			error = "Failed to load road tile " + path + ": " + e.what();
+		}
+
+		lock.lock();
+		if (error.empty())
+		{
+			loaded_tiles.push_back(loaded);
+		}
+		else
+		{
+			loader_error = error;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "road.hpp"
+#include "map.hpp"
+
+/*
+	Keeps the part of a map's road around the viewer in memory.
+
+	A tiled map lists tiles instead of segments. Each tile is an ordinary map file with only a Segments
+	list (or its compiled form, see Map), and the index gives the bounds of its tessellated segments:
+
+	Tiles:
+	    -
+	        File: city_0_0.yaml
+	        Bounds: [min_x, min_y, max_x, max_y]
+
+	Tiles that overlap the region passed to update() are parsed and tessellated by a loader thread,
+	and handed back to the calling thread a few per update so their GPU upload can be spread over
+	frames. Once more than the budget is resident, the tiles that were least recently in the region
+	are evicted. Tiles in the region are never evicted, so the budget should cover a view or two.
+
+	A map with a Segments list instead is one tile that covers everything, taken from the map in the
+	constructor, so small maps behave as if they were loaded up front.
+
+	Usage:
+
+	RoadStreamer streamer(map, DIRECTORY_MAPS, 64, 200.0f);
+	streamer.update(view_min, view_max);
+	for each tile in streamer.get_arrived_tiles(): upload streamer.get_mesh(tile)
+	for each tile in streamer.get_evicted_tiles(): free what was uploaded
+*/
+class RoadStreamer
+{
+public:
+	/* The most tiles that become resident in one update(). */
+	static const int MAX_ARRIVALS_PER_UPDATE;
+
+	/*
+		Tile files are loaded from the directory. Tiles within preload_distance of the region are loaded
+		ahead of time.
+	*/
+	RoadStreamer(Map& map, const std::string& directory, int tile_budget, float preload_distance);
+	~RoadStreamer();
+
+	/*
+		Request the tiles around the region, take in the tiles that finished loading and evict the least
+		recently used ones above the budget. Must be called from the thread that created the streamer.
+		Rethrows on this thread if the loader failed to load a tile.
+	*/
+	void update(const glm::vec2& region_min, const glm::vec2& region_max);
+
+	/* The tiles that became resident in the last update(). Their meshes are freed by the next update(). */
+	const std::vector<int>& get_arrived_tiles() const;
+
+	/* The tiles evicted by the last update(). */
+	const std::vector<int>& get_evicted_tiles() const;
+
+	/* The road of a resident tile, or nullptr if the tile is not resident. */
+	const Road* get_road(int tile) const;
+
+	/* The mesh of a tile that arrived in the last update(). */
+	const RoadMesh& get_mesh(int tile) const;
+
+	void get_tile_bounds(int tile, glm::vec2& bounds_min, glm::vec2& bounds_max) const;
+	int get_tile_count() const;
+	int get_resident_tile_count() const;
+	int get_loading_tile_count() const;
+private:
+	enum TileState
+	{
+		TILE_UNLOADED,
+		TILE_QUEUED,							// Waiting in the request queue.
+		TILE_LOADING,							// Taken by the loader, or loaded and waiting to be taken in.
+		TILE_RESIDENT
+	};
+
+	struct Tile
+	{
+		std::string file;
+		glm::vec2 bounds_min;
+		glm::vec2 bounds_max;
+		TileState state;
+		unsigned int last_wanted;				// The update() the tile was last in the region.
+		Road* road;
+		RoadMesh* mesh;							// Only between arriving and the next update().
+	};
+
+	struct LoadedTile
+	{
+		int tile;
+		Road* road;
+		RoadMesh* mesh;
+	};
+
+	std::string directory;
+	int tile_budget;
+	float preload_distance;
+	std::vector<Tile> tiles;
+	std::vector<int> resident_tiles;
+	std::vector<int> arrived_tiles;
+	std::vector<int> evicted_tiles;
+	unsigned int update_count;
+	int loading_tile_count;						// Queued or loading, counted on the calling thread.
+
+	// Shared with the loader thread, guarded by the mutex.
+	std::thread loader;
+	std::mutex mutex;
+	std::condition_variable wake_condition;
+	std::deque<int> requests;
+	std::deque<LoadedTile> loaded_tiles;
+	std::string loader_error;
+	bool stopping;
+
+	RoadStreamer(const RoadStreamer&);
+	RoadStreamer& operator=(const RoadStreamer&);
+
+	void loader_main();
+	void evict(int tile);
+};
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+/*
+	Constants shared by the simulation library and the tools. Anything that depends on SDL or OpenGL
+	belongs in car2d_main/config.hpp instead.
+*/
+
+const float PI = 3.14159265358979323846f;
+const float RADIANS_TO_DEGREES = 57.2957795130f;
+const float DEGREES_TO_RADIANS = 0.017453292519f;
+
+const float DT = 1.0f / 200.0f;
+const float RPM_TO_ANGULAR_VELOCITY = 2.0f * 3.14159265358979323846f / 60.0f;
+const float ANGULAR_VELOCITY_TO_RPM = 1.0f / RPM_TO_ANGULAR_VELOCITY;
+
+const std::string PROJECT_ROOT = "../../../";
+//const std::string PROJECT_ROOT = "./";
+const std::string DIRECTORY_ASSETS = PROJECT_ROOT + "assets/";
+const std::string DIRECTORY_CARS = DIRECTORY_ASSETS + "cars/";
+const std::string DIRECTORY_MAPS = DIRECTORY_ASSETS + "maps/";
+const std::string DIRECTORY_SCENARIOS = DIRECTORY_ASSETS + "scenarios/";
+const std::string FILE_CONFIG = "config.yaml";
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <emmintrin.h>
+
+/*
+	SSE2 versions of the few math functions needed by the vectorized physics kernels. SSE2 is
+	the baseline on every platform we build for (x64, and x86 with /arch:SSE2 which is the MSVC
+	default). The polynomials are the single precision ones from Cephes and stay within a couple
+	of ulps of the C library on the ranges the physics uses.
+*/
+
+inline __m128 simd_abs(__m128 x)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+}
+
+/* Returns -1, 0 or 1 like glm::sign. */
+inline __m128 simd_sign(__m128 x)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 positive = _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), one);
+	__m128 negative = _mm_and_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), one);
+	return _mm_sub_ps(positive, negative);
+}
+
+/* Select a where the mask is set, b otherwise. */
+inline __m128 simd_select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/* Lanewise atan2(y, x). atan2(0, 0) is 0 like the C library. */
+inline __m128 simd_atan2(__m128 y, __m128 x)
+{
+	const __m128 pi = _mm_set1_ps(3.14159265358979f);
+	const __m128 half_pi = _mm_set1_ps(1.57079632679490f);
+	const __m128 quarter_pi = _mm_set1_ps(0.78539816339745f);
+	const __m128 tan_pi_8 = _mm_set1_ps(0.41421356237310f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+	// Reduce to atan(r) with r in [0, 1].
+	__m128 ax = simd_abs(x);
+	__m128 ay = simd_abs(y);
+	__m128 swap = _mm_cmpgt_ps(ay, ax);
+	__m128 numerator = _mm_min_ps(ax, ay);
+	__m128 denominator = _mm_max_ps(ax, ay);
+	__m128 r = _mm_and_ps(_mm_div_ps(numerator, denominator), _mm_cmpgt_ps(denominator, _mm_setzero_ps()));
+
+	// Reduce further to [0, tan(pi/8)].
+	__m128 big = _mm_cmpgt_ps(r, tan_pi_8);
+	r = simd_select(big, _mm_div_ps(_mm_sub_ps(r, one), _mm_add_ps(r, one)), r);
+	__m128 offset = _mm_and_ps(big, quarter_pi);
+
+	__m128 z = _mm_mul_ps(r, r);
+	__m128 p = _mm_set1_ps(8.05374449538e-2f);
+	p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.38776856032e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+	p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(3.33329491539e-1f));
+	p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), r), r);
+	__m128 angle = _mm_add_ps(p, offset);
+
+	// Undo the reductions.
+	angle = simd_select(swap, _mm_sub_ps(half_pi, angle), angle);
+	angle = simd_select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(pi, angle), angle);
+	return _mm_or_ps(angle, _mm_and_ps(y, sign_mask));
+}
+
+/* Lanewise sin(x) and cos(x). */
+inline void simd_sincos(__m128 x, __m128& s, __m128& c)
+{
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+	__m128 sign_sin = _mm_and_ps(x, sign_mask);
+	x = simd_abs(x);
+
+	// Scale by 4/pi and round to an even octant.
+	__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+	octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(octant);
+
+	__m128 swap_sign_sin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+	__m128 polynomial_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+	__m128 sign_cos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	sign_sin = _mm_xor_ps(sign_sin, swap_sign_sin);
+
+	// Extended precision modular arithmetic.
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+	__m128 z = _mm_mul_ps(x, x);
+
+	// The cosine polynomial on [0, pi/4].
+	__m128 pc = _mm_set1_ps(2.443315711809948e-5f);
+	pc = _mm_sub_ps(_mm_mul_ps(pc, z), _mm_set1_ps(1.388731625493765e-3f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(4.166664568298827e-2f));
+	pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+	pc = _mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+	// The sine polynomial on [0, pi/4].
+	__m128 ps = _mm_set1_ps(-1.9515295891e-4f);
+	ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(8.3321608736e-3f));
+	ps = _mm_sub_ps(_mm_mul_ps(ps, z), _mm_set1_ps(1.6666654611e-1f));
+	ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+
+	s = _mm_xor_ps(simd_select(polynomial_mask, ps, pc), sign_sin);
+	c = _mm_xor_ps(simd_select(polynomial_mask, pc, ps), sign_cos);
+}
+
+/* Lanewise std::atan2, for when results must match the scalar code bit for bit. */
+inline __m128 simd_atan2_exact(__m128 y, __m128 x)
+{
+	float ys[4];
+	float xs[4];
+	_mm_storeu_ps(ys, y);
+	_mm_storeu_ps(xs, x);
+	return _mm_setr_ps(std::atan2(ys[0], xs[0]), std::atan2(ys[1], xs[1]), std::atan2(ys[2], xs[2]), std::atan2(ys[3], xs[3]));
+}
+
+/* Lanewise std::sin and std::cos, for when results must match the scalar code bit for bit. */
+inline void simd_sincos_exact(__m128 x, __m128& s, __m128& c)
+{
+	float xs[4];
+	_mm_storeu_ps(xs, x);
+	s = _mm_setr_ps(std::sin(xs[0]), std::sin(xs[1]), std::sin(xs[2]), std::sin(xs[3]));
+	c = _mm_setr_ps(std::cos(xs[0]), std::cos(xs[1]), std::cos(xs[2]), std::cos(xs[3]));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+/*
+	A bounded queue from one producer thread to one consumer thread, without locks.
+
+	The items live in a ring whose size is a power of two. The producer only writes the head and the
+	consumer only writes the tail, so each side needs a single atomic store to hand over an item.
+
+	Usage:
+
+	SpscQueue<CarInput> inputs(256);
+	Producer: inputs.push(input);
+	Consumer: while (inputs.pop(input)) handle(input);
+*/
+template <typename T>
+class SpscQueue
+{
+public:
+	/* The capacity is rounded up to a power of two. */
+	SpscQueue(int capacity)
+		: head(0)
+		, tail(0)
+	{
+		int size = 1;
+		while (size < capacity)
+		{
+			size *= 2;
+		}
+		items.resize(size);
+		mask = size - 1;
+	}
+
+	/* Returns false, dropping the item, if the queue is full. Only call from the producer. */
+	bool push(const T& item)
+	{
+		unsigned int current_head = head.load(std::memory_order_relaxed);
+		if (current_head - tail.load(std::memory_order_acquire) == items.size())
+			return false;
+
+		items[current_head & mask] = item;
+		head.store(current_head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* The number of items that can be pushed before the queue is full. Only call from the producer. */
+	int get_free_count() const
+	{
+		return static_cast<int>(items.size() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire)));
+	}
+
+	/* The oldest item, left in the queue, or nullptr if it is empty. Only call from the consumer. */
+	const T* peek() const
+	{
+		unsigned int current_tail = tail.load(std::memory_order_relaxed);
+		if (current_tail == head.load(std::memory_order_acquire))
+			return nullptr;
+
+		return &items[current_tail & mask];
+	}
+
+	/* Returns false if the queue is empty. Only call from the consumer. */
+	bool pop(T& item)
+	{
+		unsigned int current_tail = tail.load(std::memory_order_relaxed);
+		if (current_tail == head.load(std::memory_order_acquire))
+			return false;
+
+		item = items[current_tail & mask];
+		tail.store(current_tail + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	std::vector<T> items;
+	unsigned int mask;
+	std::atomic<unsigned int> head;				// The number of items pushed.
+	std::atomic<unsigned int> tail;				// The number of items popped.
+
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator=(const SpscQueue&);
+};
\ No newline at end of file
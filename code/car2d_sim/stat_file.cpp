@@ -0,0 +1,388 @@
+#include "stat_file.hpp"
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+const char StatFile::MAGIC[4] = { 'C', '2', 'S', 'T' };
+const char StatFile::CHUNK_MAGIC[4] = { 'C', '2', 'S', 'C' };
+const unsigned int StatFile::VERSION = 2;
+const int StatFile::CHUNK_ROWS = 4096;
+const int StatFile::QUEUE_ROWS = 8192;
+
+static void write_varint(unsigned long long value, std::vector<unsigned char>& bytes)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<unsigned char>(value));
+}
+
+void encode_stat_column(const StatValue* values, int row_count, StatType type, std::vector<unsigned char>& bytes)
+{
+	// Delta encode and pack the values, then replace every run of zero bytes with a zero and its length.
+	std::vector<unsigned char> packed;
+	packed.reserve(row_count * 2);
+	unsigned long long previous = 0;
+	for (int i = 0; i < row_count; ++i)
+	{
+		if (type == STAT_DOUBLE)
+		{
+			unsigned long long bits;
+			memcpy(&bits, &values[i].d, sizeof(bits));
+			write_varint(bits ^ previous, packed);
+			previous = bits;
+			continue;
+		}
+
+		unsigned int bits;
+		memcpy(&bits, &values[i], sizeof(bits));
+		if (type == STAT_INT)
+		{
+			unsigned int delta = bits - static_cast<unsigned int>(previous);
+			write_varint((delta << 1) ^ (0 - (delta >> 31)), packed);
+		}
+		else
+		{
+			write_varint(bits ^ static_cast<unsigned int>(previous), packed);
+		}
+		previous = bits;
+	}
+
+	for (size_t i = 0; i < packed.size(); )
+	{
+		if (packed[i] != 0)
+		{
+			bytes.push_back(packed[i++]);
+			continue;
+		}
+
+		size_t run_end = i;
+		while (run_end < packed.size() && packed[run_end] == 0)
+		{
+			run_end++;
+		}
+		bytes.push_back(0);
+		write_varint(static_cast<unsigned int>(run_end - i - 1), bytes);
+		i = run_end;
+	}
+}
+
+/* Reads the bytes of an encoded column back, with the zero runs expanded. */
+struct StatColumnReader
+{
+	const unsigned char* data;
+	const unsigned char* end;
+	unsigned int zeros;							// Zero bytes left of the current run.
+	bool failed;
+
+	StatColumnReader(const unsigned char* data, size_t size)
+		: data(data)
+		, end(data + size)
+		, zeros(0)
+		, failed(false)
+	{
+
+	}
+
+	unsigned int read_raw_varint()
+	{
+		unsigned int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			if (data == end)
+			{
+				failed = true;
+				return 0;
+			}
+			unsigned char byte = *data++;
+			value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+
+	unsigned char read_byte()
+	{
+		if (zeros > 0)
+		{
+			zeros--;
+			return 0;
+		}
+		if (data == end)
+		{
+			failed = true;
+			return 0;
+		}
+
+		unsigned char byte = *data++;
+		if (byte == 0)
+			zeros = read_raw_varint();
+		return byte;
+	}
+
+	unsigned long long read_varint()
+	{
+		unsigned long long value = 0;
+		for (int shift = 0; shift < 70; shift += 7)
+		{
+			unsigned char byte = read_byte();
+			value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+};
+
+bool decode_stat_column(const unsigned char* data, size_t size, StatType type, int row_count, StatValue* values)
+{
+	StatColumnReader reader(data, size);
+	unsigned long long previous = 0;
+	for (int i = 0; i < row_count && !reader.failed; ++i)
+	{
+		unsigned long long encoded = reader.read_varint();
+		if (type == STAT_DOUBLE)
+		{
+			unsigned long long bits = previous ^ encoded;
+			memcpy(&values[i].d, &bits, sizeof(bits));
+			previous = bits;
+			continue;
+		}
+
+		unsigned int narrow = static_cast<unsigned int>(encoded);
+		unsigned int bits;
+		if (type == STAT_INT)
+			bits = static_cast<unsigned int>(previous) + ((narrow >> 1) ^ (0 - (narrow & 1)));
+		else
+			bits = static_cast<unsigned int>(previous) ^ narrow;
+
+		memcpy(&values[i], &bits, sizeof(bits));
+		previous = bits;
+	}
+
+	return !reader.failed;
+}
+
+StatFile::StatFile(const std::string& path, StatFormat format)
+	: path(path)
+	, format(format)
+	, file(path, std::ios_base::binary | std::ios_base::trunc)
+	, rows(QUEUE_ROWS)
+	, stopping(false)
+	, dropped_row_count(0)
+	, chunk_row_count(0)
+{
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open file for writing: " + path);
+	}
+}
+
+StatFile::~StatFile()
+{
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+int StatFile::add_column(const std::string& name, StatType type)
+{
+	if (thread.joinable())
+		throw std::runtime_error("Failed to add column \"" + name + "\" to " + path + ": the file is already started");
+	if (columns.size() == StatRow::MAX_COLUMNS)
+		throw std::runtime_error("Failed to add column \"" + name + "\" to " + path + ": all columns are taken");
+	if (name.size() >= sizeof(StatColumnHeader().name))
+		throw std::runtime_error("Failed to add column \"" + name + "\" to " + path + ": the name is too long");
+
+	Column column;
+	column.name = name;
+	column.type = type;
+	columns.push_back(column);
+	return static_cast<int>(columns.size()) - 1;
+}
+
+void StatFile::start()
+{
+	chunk_columns.resize(columns.size());
+	for (int i = 0; i < chunk_columns.size(); ++i)
+	{
+		chunk_columns[i].reserve(CHUNK_ROWS);
+	}
+	column_sizes.resize(columns.size());
+
+	write_header();
+	thread = std::thread(&StatFile::writer_main, this);
+}
+
+bool StatFile::push(const StatRow& row)
+{
+	if (rows.push(row))
+		return true;
+
+	dropped_row_count++;
+	return false;
+}
+
+void StatFile::push_wait(const StatRow& row)
+{
+	while (!rows.push(row))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void StatFile::close()
+{
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+
+	if (file.is_open())
+	{
+		file.close();
+		if (file.fail())
+			throw std::runtime_error("Failed to write " + path);
+	}
+}
+
+int StatFile::get_column_count() const
+{
+	return static_cast<int>(columns.size());
+}
+
+long long StatFile::get_dropped_row_count() const
+{
+	return dropped_row_count;
+}
+
+void StatFile::writer_main()
+{
+	while (true)
+	{
+		// Check before draining, so every row pushed before stopping is still written.
+		bool stop = stopping;
+
+		StatRow row;
+		bool popped = false;
+		while (rows.pop(row))
+		{
+			write_row(row);
+			popped = true;
+		}
+
+		if (stop)
+			break;
+		if (!popped)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	if (format == STAT_FORMAT_COLUMNS)
+		write_chunk();
+	else
+		write_text();
+	file.flush();
+}
+
+void StatFile::write_header()
+{
+	if (format == STAT_FORMAT_CSV)
+	{
+		for (int i = 0; i < columns.size(); ++i)
+		{
+			text += columns[i].name;
+			text += i + 1 < columns.size() ? "," : "\n";
+		}
+		return;
+	}
+
+	StatFileHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.column_count = static_cast<unsigned int>(columns.size());
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (int i = 0; i < columns.size(); ++i)
+	{
+		StatColumnHeader column;
+		memset(&column, 0, sizeof(column));
+		column.type = columns[i].type;
+		memcpy(column.name, columns[i].name.c_str(), columns[i].name.size());
+		file.write(reinterpret_cast<const char*>(&column), sizeof(column));
+	}
+}
+
+void StatFile::write_row(const StatRow& row)
+{
+	if (format == STAT_FORMAT_COLUMNS)
+	{
+		for (int i = 0; i < columns.size(); ++i)
+		{
+			chunk_columns[i].push_back(row.values[i]);
+		}
+
+		if (++chunk_row_count == CHUNK_ROWS)
+			write_chunk();
+		return;
+	}
+
+	// The MSVC runtimes we build with predate a conforming snprintf.
+#ifdef _MSC_VER
+#define STAT_PRINT(...) _snprintf_s(buffer, sizeof(buffer), _TRUNCATE, __VA_ARGS__)
+#else
+#define STAT_PRINT(...) snprintf(buffer, sizeof(buffer), __VA_ARGS__)
+#endif
+	for (int i = 0; i < columns.size(); ++i)
+	{
+		char buffer[32];
+		int length;
+		if (columns[i].type == STAT_INT)
+			length = STAT_PRINT("%d", row.values[i].i);
+		else if (columns[i].type == STAT_DOUBLE)
+			length = STAT_PRINT("%.17g", row.values[i].d);
+		else
+			length = STAT_PRINT("%.9g", row.values[i].f);
+		text.append(buffer, length);
+		text += i + 1 < columns.size() ? ',' : '\n';
+	}
+#undef STAT_PRINT
+
+	if (text.size() >= 64 * 1024)
+		write_text();
+}
+
+void StatFile::write_chunk()
+{
+	if (chunk_row_count == 0)
+		return;
+
+	chunk_bytes.clear();
+	for (int i = 0; i < columns.size(); ++i)
+	{
+		size_t begin = chunk_bytes.size();
+		encode_stat_column(&chunk_columns[i][0], chunk_row_count, columns[i].type, chunk_bytes);
+		column_sizes[i] = static_cast<unsigned int>(chunk_bytes.size() - begin);
+		chunk_columns[i].clear();
+	}
+
+	StatChunkHeader header;
+	memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+	header.row_count = chunk_row_count;
+	header.size = static_cast<unsigned int>(sizeof(unsigned int) * column_sizes.size() + chunk_bytes.size());
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!column_sizes.empty())
+		file.write(reinterpret_cast<const char*>(&column_sizes[0]), sizeof(unsigned int) * column_sizes.size());
+	if (!chunk_bytes.empty())
+		file.write(reinterpret_cast<const char*>(&chunk_bytes[0]), chunk_bytes.size());
+
+	chunk_row_count = 0;
+}
+
+void StatFile::write_text()
+{
+	file.write(text.data(), text.size());
+	text.clear();
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+#include "spsc_queue.hpp"
+
+enum StatType
+{
+	STAT_FLOAT,									// A 32 bit float.
+	STAT_INT,									// A 32 bit signed int.
+	STAT_DOUBLE									// A 64 bit float, for values a float can not hold exactly, such as the time of a long run.
+};
+
+enum StatFormat
+{
+	STAT_FORMAT_COLUMNS,						// Compressed columnar chunks, see below.
+	STAT_FORMAT_CSV								// One line of text per row, with a header line.
+};
+
+union StatValue
+{
+	float f;
+	int i;
+	double d;
+};
+
+/* One row of values, by column index. */
+struct StatRow
+{
+	static const int MAX_COLUMNS = 64;
+
+	StatValue values[MAX_COLUMNS];
+
+	void set(int column, float value);
+	void set(int column, int value);
+	void set(int column, double value);
+};
+
+/*
+	The layout of a columnar stat file, in the byte order of the machine that wrote it.
+
+	The header and the column list are followed by any number of chunks of at most CHUNK_ROWS rows.
+	Each chunk stores its columns one after another with their sizes up front, so a reader can skip
+	straight to the columns it wants. A column is delta encoded (ints as the zigzagged difference from
+	the row before, floats and doubles as the bits xor those of the row before), packed as LEB128
+	varints, and the runs of zero bytes that unchanged values leave are then stored as a zero and the
+	run length. Version 1 files are the same, only without double columns.
+*/
+struct StatFileHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int column_count;					// StatColumnHeader[column_count] follow.
+};
+
+struct StatColumnHeader
+{
+	unsigned int type;							// StatType
+	char name[60];								// Zero terminated.
+};
+
+struct StatChunkHeader
+{
+	char magic[4];
+	unsigned int row_count;
+	unsigned int size;							// Of what follows: unsigned int[column_count] sizes, then the columns.
+};
+
+/* Encode the values of one column of a chunk, appending to the bytes. */
+void encode_stat_column(const StatValue* values, int row_count, StatType type, std::vector<unsigned char>& bytes);
+
+/* Decode row_count values of one column of a chunk. Returns false if the data is too short. */
+bool decode_stat_column(const unsigned char* data, size_t size, StatType type, int row_count, StatValue* values);
+
+/*
+	Writes rows of values with a fixed set of columns, on a thread of its own.
+
+	The columns are added up front. After start(), rows go through a lock free queue to a writer
+	thread that does all the encoding and writing, so pushing a row costs one copy and never waits
+	for the disk. If the writer falls so far behind that the queue fills up, rows are dropped and
+	counted instead. Columnar files are what the tools read; CSV is there for spreadsheets and scripts.
+
+	Usage:
+
+	StatFile file("run.c2dstat", STAT_FORMAT_COLUMNS);
+	int rpm = file.add_column("rpm", STAT_INT);
+	file.start();
+	each tick:
+		StatRow row;
+		row.set(rpm, engine_rpm);
+		file.push(row);
+	file.close();
+*/
+class StatFile
+{
+public:
+	static const char MAGIC[4];
+	static const char CHUNK_MAGIC[4];
+	static const unsigned int VERSION;
+	static const int CHUNK_ROWS;
+	static const int QUEUE_ROWS;
+
+	/* Open the file for writing. Throws if it can not be opened. */
+	StatFile(const std::string& path, StatFormat format);
+	~StatFile();
+
+	/* Add a column and return its index. Only before start(). */
+	int add_column(const std::string& name, StatType type);
+
+	/* Write the header and start the writer thread. */
+	void start();
+
+	/* Queue a row for writing. Returns false, dropping the row, if the queue is full. Only call from one thread. */
+	bool push(const StatRow& row);
+
+	/* Queue a row, waiting for room instead of dropping it. For tools writing out rows they already have. */
+	void push_wait(const StatRow& row);
+
+	/* Write the rows still queued and close the file. Throws if any write failed. */
+	void close();
+
+	int get_column_count() const;
+	long long get_dropped_row_count() const;
+private:
+	struct Column
+	{
+		std::string name;
+		StatType type;
+	};
+
+	std::string path;
+	StatFormat format;
+	std::ofstream file;
+	std::vector<Column> columns;
+	SpscQueue<StatRow> rows;
+	std::thread thread;
+	std::atomic<bool> stopping;
+	std::atomic<long long> dropped_row_count;
+
+	// Only touched by the writer thread once it runs.
+	std::vector<std::vector<StatValue> > chunk_columns;
+	int chunk_row_count;
+	std::vector<unsigned char> chunk_bytes;
+	std::vector<unsigned int> column_sizes;
+	std::string text;
+
+	StatFile(const StatFile&);
+	StatFile& operator=(const StatFile&);
+
+	void writer_main();
+	void write_header();
+	void write_row(const StatRow& row);
+	void write_chunk();
+	void write_text();
+};
+
+inline void StatRow::set(int column, float value)
+{
+	values[column].f = value;
+}
+
+inline void StatRow::set(int column, int value)
+{
+	values[column].i = value;
+}
+
+inline void StatRow::set(int column, double value)
+{
+	values[column].d = value;
+}
\ No newline at end of file
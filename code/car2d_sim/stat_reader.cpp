@@ -0,0 +1,175 @@
+#include "stat_reader.hpp"
+#include <stdexcept>
+#include <cstring>
+
+StatReader::StatReader()
+	: row_count(0)
+{
+
+}
+
+void StatReader::open(const std::string& path)
+{
+	this->path = path;
+	columns.clear();
+	chunks.clear();
+	row_count = 0;
+
+	if (!file.open(path))
+		throw std::runtime_error("Failed to open " + path);
+
+	const unsigned char* data = file.get_data();
+	size_t size = file.get_size();
+
+	StatFileHeader header;
+	if (size < sizeof(header))
+		throw std::runtime_error(path + " is not a stat file");
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, StatFile::MAGIC, sizeof(StatFile::MAGIC)) != 0)
+		throw std::runtime_error(path + " is not a stat file");
+	if (header.version < 1 || header.version > StatFile::VERSION)
+		throw std::runtime_error(path + " is a stat file of another version");
+
+	size_t offset = sizeof(header);
+	if (size - offset < header.column_count * sizeof(StatColumnHeader))
+		throw std::runtime_error(path + " is cut short in its column list");
+	for (unsigned int i = 0; i < header.column_count; ++i)
+	{
+		StatColumnHeader column_header;
+		memcpy(&column_header, data + offset, sizeof(column_header));
+		offset += sizeof(column_header);
+
+		column_header.name[sizeof(column_header.name) - 1] = '\0';
+		Column column;
+		column.name = column_header.name;
+		column.type = static_cast<StatType>(column_header.type);
+		columns.push_back(column);
+	}
+
+	// Index the whole chunks, stopping at the first one that is cut short or damaged.
+	size_t column_sizes_size = sizeof(unsigned int) * columns.size();
+	while (size - offset >= sizeof(StatChunkHeader))
+	{
+		StatChunkHeader chunk_header;
+		memcpy(&chunk_header, data + offset, sizeof(chunk_header));
+		if (memcmp(chunk_header.magic, StatFile::CHUNK_MAGIC, sizeof(StatFile::CHUNK_MAGIC)) != 0)
+			break;
+		if (chunk_header.size < column_sizes_size || size - offset - sizeof(chunk_header) < chunk_header.size)
+			break;
+
+		Chunk chunk;
+		chunk.first_row = row_count;
+		chunk.row_count = static_cast<int>(chunk_header.row_count);
+		chunk.column_sizes = data + offset + sizeof(chunk_header);
+		chunk.data = chunk.column_sizes + column_sizes_size;
+		chunk.data_size = chunk_header.size - column_sizes_size;
+		chunks.push_back(chunk);
+
+		row_count += chunk.row_count;
+		offset += sizeof(chunk_header) + chunk_header.size;
+	}
+}
+
+int StatReader::get_column_count() const
+{
+	return static_cast<int>(columns.size());
+}
+
+const std::string& StatReader::get_column_name(int column) const
+{
+	return columns[column].name;
+}
+
+StatType StatReader::get_column_type(int column) const
+{
+	return columns[column].type;
+}
+
+int StatReader::find_column(const std::string& name) const
+{
+	for (int i = 0; i < columns.size(); ++i)
+	{
+		if (columns[i].name == name)
+			return i;
+	}
+
+	return -1;
+}
+
+long long StatReader::get_row_count() const
+{
+	return row_count;
+}
+
+int StatReader::get_chunk_count() const
+{
+	return static_cast<int>(chunks.size());
+}
+
+long long StatReader::get_chunk_first_row(int chunk) const
+{
+	return chunk < chunks.size() ? chunks[chunk].first_row : row_count;
+}
+
+void StatReader::decode_chunk(int column, int chunk_index, std::vector<StatValue>& values) const
+{
+	const Chunk& chunk = chunks[chunk_index];
+
+	// Skip the columns before this one.
+	const unsigned char* column_data = chunk.data;
+	unsigned int column_size = 0;
+	for (int k = 0; k <= column; ++k)
+	{
+		column_data += column_size;
+		memcpy(&column_size, chunk.column_sizes + sizeof(unsigned int) * k, sizeof(column_size));
+	}
+
+	if (column_data + column_size > chunk.data + chunk.data_size)
+		throw std::runtime_error("Column " + columns[column].name + " of " + path + " runs past its chunk");
+
+	values.resize(chunk.row_count);
+	if (chunk.row_count > 0 && !decode_stat_column(column_data, column_size, columns[column].type, chunk.row_count, &values[0]))
+		throw std::runtime_error("Failed to decode column " + columns[column].name + " of " + path);
+}
+
+void StatReader::read_column(int column, int first_chunk, int end_chunk, float* values) const
+{
+	std::vector<StatValue> decoded;
+	StatType type = columns[column].type;
+	for (int i = first_chunk; i < end_chunk; ++i)
+	{
+		decode_chunk(column, i, decoded);
+
+		float* chunk_values = values + (chunks[i].first_row - chunks[first_chunk].first_row);
+		for (int k = 0; k < chunks[i].row_count; ++k)
+		{
+			if (type == STAT_INT)
+				chunk_values[k] = static_cast<float>(decoded[k].i);
+			else if (type == STAT_DOUBLE)
+				chunk_values[k] = static_cast<float>(decoded[k].d);
+			else
+				chunk_values[k] = decoded[k].f;
+		}
+	}
+}
+
+void StatReader::read_column(int column, int first_chunk, int end_chunk, double* values) const
+{
+	std::vector<StatValue> decoded;
+	StatType type = columns[column].type;
+	for (int i = first_chunk; i < end_chunk; ++i)
+	{
+		decode_chunk(column, i, decoded);
+
+		double* chunk_values = values + (chunks[i].first_row - chunks[first_chunk].first_row);
+		for (int k = 0; k < chunks[i].row_count; ++k)
+		{
+			if (type == STAT_INT)
+				chunk_values[k] = decoded[k].i;
+			else if (type == STAT_DOUBLE)
+				chunk_values[k] = decoded[k].d;
+			else
+				chunk_values[k] = decoded[k].f;
+		}
+	}
+}
\ No newline at end of file
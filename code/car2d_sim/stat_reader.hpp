@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "stat_file.hpp"
+#include "mapped_file.hpp"
+
+/*
+	Reads the columnar files written by StatFile, straight out of a file mapping.
+
+	Opening a file only reads the column list and the chunk headers. The values of a column are decoded
+	when asked for, chunk by chunk, and the other columns are never touched. Chunks are independent, so
+	ranges of them can be decoded on different threads. A file cut short, e.g. by a crash, is read up
+	to its last whole chunk.
+
+	Usage:
+
+	StatReader reader;
+	reader.open("run.c2dstat");
+	std::vector<float> rpm(reader.get_row_count());
+	reader.read_column(reader.find_column("rpm"), 0, reader.get_chunk_count(), &rpm[0]);
+*/
+class StatReader
+{
+public:
+	StatReader();
+
+	/* Map the file and index its chunks. Throws if it is not a stat file. */
+	void open(const std::string& path);
+
+	int get_column_count() const;
+	const std::string& get_column_name(int column) const;
+	StatType get_column_type(int column) const;
+
+	/* The index of the column with the given name, or -1 if there is none. */
+	int find_column(const std::string& name) const;
+
+	long long get_row_count() const;
+	int get_chunk_count() const;
+	long long get_chunk_first_row(int chunk) const;
+
+	/* Decode the column for the chunks in [first_chunk, end_chunk) into values, as floats, from the first row of first_chunk on. */
+	void read_column(int column, int first_chunk, int end_chunk, float* values) const;
+
+	/* As above, as doubles, which hold every int and double column exactly. */
+	void read_column(int column, int first_chunk, int end_chunk, double* values) const;
+private:
+	struct Column
+	{
+		std::string name;
+		StatType type;
+	};
+
+	struct Chunk
+	{
+		long long first_row;
+		int row_count;
+		const unsigned char* column_sizes;		// unsigned int[column_count], not necessarily aligned.
+		const unsigned char* data;
+		size_t data_size;
+	};
+
+	std::string path;
+	MappedFile file;
+	std::vector<Column> columns;
+	std::vector<Chunk> chunks;
+	long long row_count;
+
+	StatReader(const StatReader&);
+	StatReader& operator=(const StatReader&);
+
+	void decode_chunk(int column, int chunk_index, std::vector<StatValue>& values) const;
+};
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "telemetry.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+Telemetry::Telemetry()
+{
+	memset(values, 0, sizeof(values));
+}
+
+int Telemetry::register_channel(const std::string& key, TelemetryType type, const std::string& format)
+{
+	int id = find_channel(key);
+	if (id != -1)
+		return id;
+
+	if (channels.size() == MAX_CHANNELS)
+		throw std::runtime_error("Failed to register telemetry channel \"" + key + "\": all channels are taken");
+
+	Channel channel;
+	channel.key = key;
+	channel.format = format;
+	channel.type = type;
+	channels.push_back(channel);
+
+	return static_cast<int>(channels.size()) - 1;
+}
+
+int Telemetry::find_channel(const std::string& key) const
+{
+	for (int i = 0; i < channels.size(); ++i)
+	{
+		if (channels[i].key == key)
+			return i;
+	}
+
+	return -1;
+}
+
+void Telemetry::copy_values(const Telemetry& other)
+{
+	memcpy(values, other.values, sizeof(values));
+}
+
+int Telemetry::format(int id, char* buffer, int buffer_size) const
+{
+	if (buffer_size <= 0)
+		return 0;
+
+	const char* format = channels[id].format.c_str();
+	const Value& value = values[id];
+
+	// The MSVC runtimes we build with predate a conforming snprintf.
+#ifdef _MSC_VER
+#define TELEMETRY_PRINT(...) _snprintf_s(buffer, buffer_size, _TRUNCATE, __VA_ARGS__)
+#else
+#define TELEMETRY_PRINT(...) snprintf(buffer, buffer_size, __VA_ARGS__)
+#endif
+	int length = 0;
+	switch (channels[id].type)
+	{
+		case TELEMETRY_NONE: length = TELEMETRY_PRINT("%s", format); break;
+		case TELEMETRY_FLOAT: length = TELEMETRY_PRINT(format, value.f[0]); break;
+		case TELEMETRY_FLOAT2: length = TELEMETRY_PRINT(format, value.f[0], value.f[1]); break;
+		case TELEMETRY_INT: length = TELEMETRY_PRINT(format, value.i[0]); break;
+		case TELEMETRY_INT2: length = TELEMETRY_PRINT(format, value.i[0], value.i[1]); break;
+	}
+#undef TELEMETRY_PRINT
+
+	// Both report truncation differently, the buffer holds whatever fit either way.
+	if (length < 0 || length >= buffer_size)
+		length = static_cast<int>(strlen(buffer));
+	return length;
+}
+
+int Telemetry::get_channel_count() const
+{
+	return static_cast<int>(channels.size());
+}
+
+const std::string& Telemetry::get_key(int id) const
+{
+	return channels[id].key;
+}
+
+TelemetryType Telemetry::get_type(int id) const
+{
+	return channels[id].type;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+enum TelemetryType
+{
+	TELEMETRY_NONE,								// No value, the format is printed as is (e.g. an empty separator line).
+	TELEMETRY_FLOAT,							// One float.
+	TELEMETRY_FLOAT2,							// Two floats.
+	TELEMETRY_INT,								// One int.
+	TELEMETRY_INT2								// Two ints.
+};
+
+/*
+	A fixed table of debug values written by the simulation and read by whoever wants to show them.
+
+	Channels are registered once, up front, with a key, a type and a printf style format. Registering
+	returns a small integer id and the hot path only stores raw values into the slot with that id,
+	so writing a value costs the same as writing a member variable. Nothing is formatted until
+	format() is called, which the overlay does at most once per rendered frame.
+
+	Usage:
+
+	Telemetry telemetry;
+	int rpm = telemetry.register_channel("rpm", TELEMETRY_INT, "Engine RPM: %d rev/min");
+	telemetry.set(rpm, (int) engine_rpm);
+	...
+	char line[128];
+	telemetry.format(rpm, line, sizeof(line));
+*/
+class Telemetry
+{
+public:
+	static const int MAX_CHANNELS = 64;
+
+	Telemetry();
+
+	/*
+		Register a channel and return its id. Registering an existing key returns the id it already has.
+		Ids are handed out in registration order, which is also the order the overlay lists them in.
+	*/
+	int register_channel(const std::string& key, TelemetryType type, const std::string& format);
+
+	/* Return the id of the channel with the given key, or -1 if there is none. */
+	int find_channel(const std::string& key) const;
+
+	void set(int id, float value);
+	void set(int id, float x, float y);
+	void set(int id, int value);
+	void set(int id, int x, int y);
+
+	/* Take the values of every channel from another table with the same channels, e.g. a copy of this one. */
+	void copy_values(const Telemetry& other);
+
+	float get_float(int id, int component = 0) const;
+	int get_int(int id, int component = 0) const;
+
+	/*
+		Print the channel into the buffer, truncating if it does not fit. Returns the length of the text.
+	*/
+	int format(int id, char* buffer, int buffer_size) const;
+
+	int get_channel_count() const;
+	const std::string& get_key(int id) const;
+	TelemetryType get_type(int id) const;
+private:
+	struct Channel
+	{
+		std::string key;
+		std::string format;
+		TelemetryType type;
+	};
+
+	union Value
+	{
+		float f[2];
+		int i[2];
+	};
+
+	std::vector<Channel> channels;
+	Value values[MAX_CHANNELS];
+};
+
+inline void Telemetry::set(int id, float value)
+{
+	values[id].f[0] = value;
+}
+
+inline void Telemetry::set(int id, float x, float y)
+{
+	values[id].f[0] = x;
+	values[id].f[1] = y;
+}
+
+inline void Telemetry::set(int id, int value)
+{
+	values[id].i[0] = value;
+}
+
+inline void Telemetry::set(int id, int x, int y)
+{
+	values[id].i[0] = x;
+	values[id].i[1] = y;
+}
+
+inline float Telemetry::get_float(int id, int component) const
+{
+	return values[id].f[component];
+}
+
+inline int Telemetry::get_int(int id, int component) const
+{
+	return values[id].i[component];
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "ticker.hpp"
+
+Ticker::Ticker(float dt, int max_ticks_per_frame)
+	: dt(Duration(static_cast<long long>(dt * 1e9 + 0.5)))
+	, frame_time(0)
+	, frame_count(0)
+	, max_ticks_per_frame(max_ticks_per_frame)
+	, current_fixed_tick_count(0)
+	, total_fixed_tick_count(0)
+	, due_tick_count(0)
+	, dropped_tick_count(0)
+	, interpolation(0)
+{
+
+}
+
+void Ticker::start()
+{
+	start_clock = Clock::now();
+	last_clock = start_clock;
+}
+
+void Ticker::tick()
+{
+	frame_count++;
+
+	Clock::time_point current_clock = Clock::now();
+	frame_time = std::chrono::duration_cast<Duration>(current_clock - last_clock);
+	last_clock = current_clock;
+
+	// The tick n is due at start + n * dt, counting dropped ticks, so there is no remainder to carry.
+	long long elapsed = std::chrono::duration_cast<Duration>(current_clock - start_clock).count();
+	long long ticks = elapsed / dt.count() - due_tick_count;
+	if (ticks > max_ticks_per_frame)
+	{
+		dropped_tick_count += ticks - max_ticks_per_frame;
+		due_tick_count += ticks - max_ticks_per_frame;
+		ticks = max_ticks_per_frame;
+	}
+
+	current_fixed_tick_count = static_cast<int>(ticks);
+	due_tick_count += ticks;
+	interpolation = static_cast<float>(elapsed % dt.count()) / dt.count();
+}
+
+bool Ticker::poll_fixed_tick()
+{
+	bool tick = current_fixed_tick_count >= 1;
+	if (tick)
+	{
+		current_fixed_tick_count--;
+		total_fixed_tick_count++;
+	}
+	return tick;
+}
+
+float Ticker::get_interpolation() const
+{
+	return interpolation;
+}
+
+float Ticker::get_fixed_delta_time() const
+{
+	return dt.count() * 1e-9f;
+}
+
+Ticker::Clock::time_point Ticker::get_fixed_tick_time() const
+{
+	return start_clock + dt * (due_tick_count - current_fixed_tick_count);
+}
+
+Ticker::Clock::time_point Ticker::get_next_fixed_tick_time() const
+{
+	return start_clock + dt * (due_tick_count - current_fixed_tick_count + 1);
+}
+
+float Ticker::get_fixed_simulated_time() const
+{
+	return static_cast<float>(total_fixed_tick_count * dt.count() * 1e-9);
+}
+
+long long Ticker::get_fixed_tick_count() const
+{
+	return total_fixed_tick_count;
+}
+
+long long Ticker::get_dropped_tick_count() const
+{
+	return dropped_tick_count;
+}
+
+int Ticker::get_frame_count() const
+{
+	return frame_count;
+}
+
+float Ticker::get_frame_time() const
+{
+	return frame_time.count() * 1e-9f;
+}
+
+float Ticker::get_fps() const
+{
+	return (frame_time.count() != 0) ? 1e9f / frame_time.count() : 1000.0f;
+}
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
-#include <SDL2/SDL.h>
+#include <chrono>
+#include "monotonic_clock.hpp"
 
 /*
 	Manages the game loop with semi-fixed timestep. Details: http://gafferongames.com/game-physics/fix-your-timestep/.
 
+	Time is kept in whole nanoseconds of a monotonic clock and every fixed tick has a due time of
+	exactly start + n * dt, so the ticks never drift however long the ticker runs. When more ticks are
+	due at once than a frame may run, the oldest are dropped rather than carried over, and counted.
+
 	Usage:
 
 	Ticker ticker(1.0f / 60.0f, 5);
@@ -24,6 +29,9 @@
 class Ticker
 {
 public:
+	typedef MonotonicClock Clock;
+	typedef std::chrono::nanoseconds Duration;
+
 	/*
 		Initialize the ticker. Specify the delta time (in seconds) for the fixed timestep updates and
 		the maximum number of fixed timestep ticks that can happen per frame.
@@ -57,6 +65,16 @@ public:
 	*/
 	float get_fixed_delta_time() const;
 
+	/*
+		Get the time the fixed tick last returned by poll_fixed_tick() was due.
+	*/
+	Clock::time_point get_fixed_tick_time() const;
+
+	/*
+		Get the time the next fixed tick is due.
+	*/
+	Clock::time_point get_next_fixed_tick_time() const;
+
 	/*
 		Get the amount of time that has been simulated by the fixed timestep logic. This is the number
 		of fixed ticks simulated times the delta time.
@@ -66,7 +84,12 @@ public:
 	/*
 		Get the number of fixed timestep logic ticks that have been simulated.
 	*/
-	int get_fixed_tick_count() const;
+	long long get_fixed_tick_count() const;
+
+	/*
+		Get the number of fixed ticks that were skipped because more than max_ticks_per_frame were due.
+	*/
+	long long get_dropped_tick_count() const;
 
 	/*
 		Get the number of frames simulated. This is equal to the number of times tick() has been called.
@@ -83,14 +106,15 @@ public:
 	*/
 	float get_fps() const;
 private:
-	Uint32 last_clock;
-	Uint32 delta_clock;
+	Clock::time_point start_clock;
+	Clock::time_point last_clock;
+	Duration dt;
+	Duration frame_time;
 	int frame_count;
 	int max_ticks_per_frame;
-	int current_fixed_tick_count;
-	int total_fixed_tick_count;
-	float accumulator;
-	float dt;
-	float t;
+	int current_fixed_tick_count;				// Ticks left to poll this frame.
+	long long total_fixed_tick_count;			// Ticks polled so far.
+	long long due_tick_count;					// Ticks due by the last tick(), including those left to poll.
+	long long dropped_tick_count;
 	float interpolation;
 };
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+
+/*
+	Hands the newest value from one producer thread to one consumer thread, without either waiting.
+
+	There are three buffers: the one being written, the one being read and a spare. publish() swaps
+	the written buffer with the spare and consume() swaps the spare with the read one if it is newer,
+	both with a single atomic exchange. The consumer always has a complete value and skips any it was
+	too slow to see. A buffer handed back to the producer holds an old value, so publish whole values.
+
+	Usage:
+
+	Producer:
+	buffer.get_write_buffer() = next_value;
+	buffer.publish();
+
+	Consumer:
+	buffer.consume();
+	use(buffer.get_read_buffer());
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: write_index(0)
+		, read_index(1)
+		, spare(2)
+	{
+
+	}
+
+	/* Set all three buffers, e.g. so the consumer has a value before the first publish. Not thread safe. */
+	void reset(const T& value)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			buffers[i] = value;
+		}
+		write_index = 0;
+		read_index = 1;
+		spare.store(2);
+	}
+
+	/* The buffer for the producer to fill before publishing. */
+	T& get_write_buffer()
+	{
+		return buffers[write_index];
+	}
+
+	void publish()
+	{
+		write_index = spare.exchange(write_index | NEW_BIT) & INDEX_MASK;
+	}
+
+	/* Switch to the newest published value. Returns false, keeping the old one, if nothing was published since. */
+	bool consume()
+	{
+		if ((spare.load() & NEW_BIT) == 0)
+			return false;
+
+		read_index = spare.exchange(read_index) & INDEX_MASK;
+		return true;
+	}
+
+	const T& get_read_buffer() const
+	{
+		return buffers[read_index];
+	}
+private:
+	static const int INDEX_MASK = 3;
+	static const int NEW_BIT = 4;
+
+	T buffers[3];
+	int write_index;							// Only touched by the producer.
+	int read_index;								// Only touched by the consumer.
+	std::atomic<int> spare;						// The spare index, with NEW_BIT set if it was published and not consumed yet.
+
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+};
\ No newline at end of file
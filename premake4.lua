@@ -1,8 +1,10 @@
+newoption { trigger = "profile", description = "Compile in the CPU and GPU profiler (CAR2D_PROFILE)" }
+
 solution "car2d"
     configurations { "Debug", "Release" }
     platforms { "x32", "x64" }
-    location "vs2013"
-    
+    location (_ACTION)
+
 	configuration { "x32", "Debug" }
 		targetdir "bin/x86/debug/"
         debugdir "bin/x86/debug/"
@@ -23,18 +25,73 @@ solution "car2d"
         debugdir "bin/x64/release/"
         libdirs "external/lib/x64/"
 		flags { "Optimize" }
+	configuration { "vs*" }
+		buildoptions { "/W4" }
+	configuration { "gmake" }
+		buildoptions { "-std=c++11", "-Wall" }
 	configuration {}
-    
-    includedirs { "external/include/" }
-    buildoptions { "/W4" }
-        
+
+    includedirs { "external/include/", "code/" }
+
+    if _OPTIONS["profile"] then
+        defines { "CAR2D_PROFILE" }
+    end
+
+    -- Car physics, road geometry and timing. Must not depend on SDL2, gl3w or freetype-gl so it can run headless.
+    project "car2d_sim"
+        kind "StaticLib"
+        language "C++"
+        files { "code/car2d_sim/**.hpp", "code/car2d_sim/**.cpp" }
+        objdir "build/car2d_sim/obj/"
+
     project "car2d_main"
         kind "ConsoleApp"
         language "C++"
         files { "code/car2d_main/**.hpp", "code/car2d_main/**.cpp", "assets/shaders/**.vert", "assets/shaders/**.frag" }
         objdir "build/car2d_main/obj/"
-        
-        configuration { "Debug" }
-            links { "opengl32", "SDL2", "SDL2main", "gl3w", "libyaml-cppmdd", "freetype", "freetype-gl" }
-        configuration { "Release" }
-            links { "opengl32", "SDL2", "SDL2main", "gl3w", "libyaml-cppmd", "freetype", "freetype-gl" }
\ No newline at end of file
+
+        configuration { "windows", "Debug" }
+            links { "car2d_sim", "opengl32", "SDL2", "SDL2main", "gl3w", "libyaml-cppmdd", "freetype", "freetype-gl" }
+        configuration { "windows", "Release" }
+            links { "car2d_sim", "opengl32", "SDL2", "SDL2main", "gl3w", "libyaml-cppmd", "freetype", "freetype-gl" }
+        configuration { "linux" }
+            links { "car2d_sim", "GL", "SDL2", "gl3w", "yaml-cpp", "freetype-gl", "freetype", "pthread" }
+
+    -- Headless benchmarks for the simulation library.
+    project "car2d_bench"
+        kind "ConsoleApp"
+        language "C++"
+        files { "code/car2d_bench/**.hpp", "code/car2d_bench/**.cpp" }
+        objdir "build/car2d_bench/obj/"
+
+        configuration { "windows", "Debug" }
+            links { "car2d_sim", "libyaml-cppmdd" }
+        configuration { "windows", "Release" }
+            links { "car2d_sim", "libyaml-cppmd" }
+        configuration { "linux" }
+            links { "car2d_sim", "yaml-cpp", "pthread" }
+
+    -- Compiles maps into the binary form the game maps straight into memory.
+    project "car2d_mapc"
+        kind "ConsoleApp"
+        language "C++"
+        files { "code/car2d_mapc/**.hpp", "code/car2d_mapc/**.cpp" }
+        objdir "build/car2d_mapc/obj/"
+
+        configuration { "windows", "Debug" }
+            links { "car2d_sim", "libyaml-cppmdd" }
+        configuration { "windows", "Release" }
+            links { "car2d_sim", "libyaml-cppmd" }
+        configuration { "linux" }
+            links { "car2d_sim", "yaml-cpp", "pthread" }
+
+    -- Aggregates the telemetry recorded by StatFile.
+    project "car2d_query"
+        kind "ConsoleApp"
+        language "C++"
+        files { "code/car2d_query/**.hpp", "code/car2d_query/**.cpp" }
+        objdir "build/car2d_query/obj/"
+
+        links { "car2d_sim" }
+        configuration { "linux" }
+            links { "pthread" }
\ No newline at end of file